@@ -1,22 +1,7 @@
 #include "5stage_bypass.hpp"
+#include "Simulator.hpp"
 
 int main(int argc, char *argv[])
 {
-	if (argc != 2)
-	{
-		std::cerr << "Required argument: file_name\n./MIPS_interpreter <file name>\n";
-		return 0;
-	}
-	std::ifstream file(argv[1]);
-	MIPS_Architecture *mips;
-	if (file.is_open())
-		mips = new MIPS_Architecture(file);
-	else
-	{
-		std::cerr << "File could not be opened. Terminating...\n";
-		return 0;
-	}
-
-	mips->executeCommandspipelinedbypass();
-	return 0;
+	return simulate<MIPS_Architecture>(argc, argv);
 }
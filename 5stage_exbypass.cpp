@@ -0,0 +1,7 @@
+#include "5stage_exbypass.hpp"
+#include "Simulator.hpp"
+
+int main(int argc, char *argv[])
+{
+	return simulate<MIPS_Architecture>(argc, argv);
+}
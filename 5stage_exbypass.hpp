@@ -0,0 +1,9 @@
+#ifndef __5STAGE_EXBYPASS_HPP__
+#define __5STAGE_EXBYPASS_HPP__
+
+#include "Hazard.hpp"
+
+// five stage pipeline with forwarding of ALU results from EX only
+typedef MIPS_Pipeline<EXBypass> MIPS_Architecture;
+
+#endif
@@ -2,127 +2,346 @@
 #define __B_H_HPP__
 
 #include <vector>
-#include <bitset>
 #include <cassert>
+#include <cstdint>
+#include <string>
+#include "Checkpoint.hpp"
 
+/*
+    table of 2-bit saturating counters packed 32 to a 64-bit word (a 16K entry table takes 4 KB),
+    counter values 0 and 1 predict not taken, 2 and 3 taken
+*/
+struct CounterTable {
+    std::vector<uint64_t> words;
+    CounterTable(uint32_t size, int value) : words((size + 31) / 32, 0x5555555555555555ull * (value & 3)) {}
+
+    uint32_t get(uint32_t index) const {
+        return (words[index >> 5] >> ((index & 31) << 1)) & 3;
+    }
+
+    bool taken(uint32_t index) const {
+        return (words[index >> 5] >> ((index & 31) << 1)) & 2;
+    }
+
+    template <class Archive>
+    void checkpointState(Archive &archive) {
+        archive(words);
+    }
+
+    // saturating increment when taken, decrement otherwise, without branches
+    void update(uint32_t index, bool taken) {
+        uint64_t &word = words[index >> 5];
+        uint32_t shift = (index & 31) << 1;
+        uint32_t value = (word >> shift) & 3;
+        uint32_t next = value + (taken & (value != 3)) - (!taken & (value != 0));
+        word ^= (uint64_t)(value ^ next) << shift;
+    }
+};
+
+/*
+    static predictor interface: a predictor derives from BranchPredictor<itself> and defines
+        bool predict(uint32_t pc)               prediction for the branch at pc (0-based)
+        void update(uint32_t pc, bool taken)    outcome of that branch once resolved
+        checkpointState(archive)                its tables and history, see Checkpoint.hpp
+    the pipeline is instantiated per predictor type so that both calls inline into fetch and resolve
+*/
+template <class Derived>
 struct BranchPredictor {
-    virtual bool predict(uint32_t pc) = 0;
-    virtual void update(uint32_t pc, bool taken) = 0;
+    Derived &self() { return static_cast<Derived &>(*this); }
 };
 
-struct SaturatingBranchPredictor : public BranchPredictor {
-    std::vector<std::bitset<2>> table;
+struct SaturatingBranchPredictor : public BranchPredictor<SaturatingBranchPredictor> {
+    CounterTable table;
     SaturatingBranchPredictor(int value) : table(1 << 14, value) {}
 
     bool predict(uint32_t pc) {
-        std::bitset<14> index_14(pc & 0x3fff);
-        // std::cout<< index_14<<std::endl;
-        uint32_t ind = index_14.to_ulong();
-        std::bitset<2> value = table[ind];
-        return value.test(1);
+        return table.taken(pc & 0x3fff);
     }
 
     void update(uint32_t pc, bool taken) {
-        std::bitset<14> index_14(pc & 0x3fff);
-        // std::cout<< index_14<<std::endl;
-        uint32_t ind = index_14.to_ulong();
-        std::bitset<2> value = table[ind];
-        if (taken) {
-            if (value == std::bitset<2>("00")) {
-                value = std::bitset<2>("01");
-            }
-            else if(value == std::bitset<2>("01")) {
-                value = std::bitset<2>("10");
-            }
-            else if(value == std::bitset<2>("10")) {
-                value = std::bitset<2>("11");
-            }
-        } else {
-            if (value == std::bitset<2>("01")) {
-                value = std::bitset<2>("00");
-            }
-            else if(value == std::bitset<2>("10")) {
-                value = std::bitset<2>("01");
-            }
-            else if(value == std::bitset<2>("11")) {
-                value = std::bitset<2>("10");
-            }
-        }
-        table[ind] = value;
+        table.update(pc & 0x3fff, taken);
+    }
+
+    template <class Archive>
+    void checkpointState(Archive &archive) {
+        table.checkpointState(archive);
     }
 };
 
-struct BHRBranchPredictor : public BranchPredictor {
-    std::vector<std::bitset<2>> bhrTable;
-    std::bitset<2> bhr;
-    BHRBranchPredictor(int value) : bhrTable(1 << 2, value), bhr(value) {}
+struct BHRBranchPredictor : public BranchPredictor<BHRBranchPredictor> {
+    CounterTable bhrTable;
+    uint32_t bhr;   // last two outcomes, most recent in bit 0
+    BHRBranchPredictor(int value) : bhrTable(1 << 2, value), bhr(value & 3) {}
+
+    bool predict(uint32_t) {
+        return bhrTable.taken(bhr);
+    }
+
+    void update(uint32_t, bool taken) {
+        bhrTable.update(bhr, taken);
+        bhr = ((bhr << 1) | taken) & 3;
+    }
+
+    template <class Archive>
+    void checkpointState(Archive &archive) {
+        bhrTable.checkpointState(archive);
+        archive(bhr);
+    }
+};
+
+
+struct SaturatingBHRBranchPredictor : public BranchPredictor<SaturatingBHRBranchPredictor> {
+    uint32_t bhr;
+    CounterTable combination;   // indexed by the low 14 pc bits followed by the 2 history bits
+    SaturatingBHRBranchPredictor(int value, int size) : bhr(value & 3), combination(size, value) {
+        assert(size <= (1 << 16));
+    }
 
     bool predict(uint32_t pc) {
-        uint32_t index = bhr.to_ulong();
-        std::bitset<2> value = bhrTable[index];
-        return value.test(1);
+        return combination.taken((pc & 0x3fff) * 4 + bhr);
     }
 
     void update(uint32_t pc, bool taken) {
-        uint32_t index = bhr.to_ulong();
-        std::bitset<2> value = bhrTable[index];
-        if (taken) {
-            if (value != std::bitset<2>("11")) {
-                value = value.to_ulong() + 1;
-            }
-        } else {
-            if (value != std::bitset<2>("00")) {
-                value = value.to_ulong() - 1;
-            }
-        }
-        bhr <<= 1;
-        bhr.set(0, taken);
-        bhrTable[index] = value;
+        combination.update((pc & 0x3fff) * 4 + bhr, taken);
+        bhr = ((bhr << 1) | taken) & 3;
+    }
+
+    template <class Archive>
+    void checkpointState(Archive &archive) {
+        combination.checkpointState(archive);
+        archive(bhr);
     }
 };
 
+// pc xor the global history into one table of 2^bits counters, the history using historyBits <= bits
+struct GShareBranchPredictor : public BranchPredictor<GShareBranchPredictor> {
+    CounterTable table;
+    uint32_t history = 0, mask, historyMask;
+    GShareBranchPredictor(int value, int bits, int historyBits) : table(1u << bits, value), mask((1u << bits) - 1),
+                                                                  historyMask((1u << historyBits) - 1) {
+        assert(historyBits <= bits);
+    }
 
-struct SaturatingBHRBranchPredictor : public BranchPredictor {
-    std::vector<std::bitset<2>> bhrTable;
-    std::bitset<2> bhr;
-    std::vector<std::bitset<2>> table;
-    std::vector<std::bitset<2>> combination;
-    SaturatingBHRBranchPredictor(int value, int size) : bhrTable(1 << 2, value), bhr(value), table(1 << 14, value), combination(size, value) {
-        assert(size <= (1 << 16));
+    uint32_t index(uint32_t pc) const {
+        return (pc ^ (history & historyMask)) & mask;
     }
 
     bool predict(uint32_t pc) {
-        uint32_t bhr_ind = bhr.to_ulong();
-        std::bitset<14> index_14(pc & 0x3fff);
-        uint32_t sat_ind = index_14.to_ulong();
-        uint32_t comb_ind= sat_ind*4+bhr_ind;
-        std::bitset<2> value = combination[comb_ind];
-        return value.test(1);
+        return table.taken(index(pc));
     }
 
     void update(uint32_t pc, bool taken) {
-        uint32_t bhr_ind = bhr.to_ulong();
-        std::bitset<14> index_14(pc & 0x3fff);
-        uint32_t sat_ind = index_14.to_ulong();
-        uint32_t comb_ind= sat_ind*4+bhr_ind;
-        std::bitset<2> value = combination[comb_ind];
-        if (taken) {
-            if (value != std::bitset<2>("11")) {
-                value = value.to_ulong() + 1;
-            }
-            
-        } else {
-            if (value != std::bitset<2>("00")) {
-                value = value.to_ulong() - 1;
+        table.update(index(pc), taken);
+        history = (history << 1) | taken;
+    }
+
+    template <class Archive>
+    void checkpointState(Archive &archive) {
+        table.checkpointState(archive);
+        archive(history);
+    }
+};
+
+/*
+    tournament of a bimodal table (by pc) and gshare: a chooser of 2^bits counters per pc picks gshare from 2 up,
+    and moves towards whichever component was right when they disagree
+*/
+struct TournamentBranchPredictor : public BranchPredictor<TournamentBranchPredictor> {
+    CounterTable local, chooser;
+    GShareBranchPredictor global;
+    uint32_t mask;
+    TournamentBranchPredictor(int value, int bits) : local(1u << bits, value), chooser(1u << bits, value),
+                                                     global(value, bits, bits), mask((1u << bits) - 1) {}
+
+    bool predict(uint32_t pc) {
+        return chooser.taken(pc & mask) ? global.predict(pc) : local.taken(pc & mask);
+    }
+
+    void update(uint32_t pc, bool taken) {
+        bool localTaken = local.taken(pc & mask), globalTaken = global.predict(pc);
+        if (localTaken != globalTaken)
+            chooser.update(pc & mask, globalTaken == taken);
+        local.update(pc & mask, taken);
+        global.update(pc, taken);
+    }
+
+    template <class Archive>
+    void checkpointState(Archive &archive) {
+        local.checkpointState(archive);
+        chooser.checkpointState(archive);
+        global.checkpointState(archive);
+    }
+};
+
+/*
+    TAGE-lite: a bimodal base table and TABLES tagged tables of 2^bits entries indexed by the pc hashed with
+    geometrically longer global histories; the longest matching table provides the prediction, and a misprediction
+    allocates an entry in a longer table whose useful counter has dropped to 0
+*/
+struct TageBranchPredictor : public BranchPredictor<TageBranchPredictor> {
+    static const int TABLES = 4, TAG_BITS = 8;
+    static constexpr int HISTORY[TABLES] = {4, 8, 16, 32};
+    struct Entry {
+        uint16_t tag = 0xffff;                      // no tag matches an entry never allocated
+        uint8_t counter = 0, useful = 0;            // counter 0..7, 4 up predicts taken; useful 0..3
+    };
+    CounterTable base;
+    std::vector<Entry> tables[TABLES];
+    uint64_t history = 0;
+    int bits;
+    TageBranchPredictor(int value, int bits) : base(1u << bits, value), bits(bits) {
+        for (auto &table : tables)
+            table.resize(1u << bits);
+    }
+
+    // the newest length bits of the history xor folded down to width bits
+    uint32_t fold(int length, int width) const {
+        uint64_t h = history & ((1ull << length) - 1);
+        uint32_t folded = 0;
+        for (; h; h >>= width)
+            folded ^= h & ((1u << width) - 1);
+        return folded;
+    }
+
+    uint32_t index(int t, uint32_t pc) const {
+        return (pc ^ (pc >> (bits - t)) ^ fold(HISTORY[t], bits)) & ((1u << bits) - 1);
+    }
+
+    uint16_t tag(int t, uint32_t pc) const {
+        return (pc ^ fold(HISTORY[t], TAG_BITS) ^ (fold(HISTORY[t], TAG_BITS - 1) << 1)) & ((1u << TAG_BITS) - 1);
+    }
+
+    // longest table whose entry for pc carries its tag, -1 for none
+    int provider(uint32_t pc, int below = TABLES) const {
+        for (int t = below - 1; t >= 0; --t)
+            if (tables[t][index(t, pc)].tag == tag(t, pc))
+                return t;
+        return -1;
+    }
+
+    bool prediction(int t, uint32_t pc) const {
+        return t < 0 ? base.taken(pc & ((1u << bits) - 1)) : tables[t][index(t, pc)].counter >= 4;
+    }
+
+    bool predict(uint32_t pc) {
+        return prediction(provider(pc), pc);
+    }
+
+    void update(uint32_t pc, bool taken) {
+        int t = provider(pc);
+        bool predicted = prediction(t, pc);
+        if (t < 0)
+            base.update(pc & ((1u << bits) - 1), taken);
+        else {
+            Entry &entry = tables[t][index(t, pc)];
+            if (predicted != prediction(provider(pc, t), pc))
+                entry.useful += (predicted == taken) ? (entry.useful < 3) : -(entry.useful > 0);
+            entry.counter += taken ? (entry.counter < 7) : -(entry.counter > 0);
+        }
+        if (predicted != taken && t < TABLES - 1) {
+            bool allocated = false;
+            for (int u = t + 1; u < TABLES && !allocated; ++u) {
+                Entry &entry = tables[u][index(u, pc)];
+                if (entry.useful == 0) {
+                    entry.tag = tag(u, pc);
+                    entry.counter = taken ? 4 : 3;
+                    allocated = true;
+                }
             }
+            for (int u = t + 1; u < TABLES && !allocated; ++u)
+                tables[u][index(u, pc)].useful -= tables[u][index(u, pc)].useful > 0;
         }
-        combination[comb_ind] = value;
-        bhr <<= 1;
-        bhr.set(0, taken);
+        history = (history << 1) | taken;
     }
+
+    template <class Archive>
+    void checkpointState(Archive &archive) {
+        base.checkpointState(archive);
+        for (auto &table : tables)
+            archive(table);
+        archive(history);
+    }
+};
+
+/*
+    type erased predictor for selection at run time, one indirect call per predict and update;
+    owns the predictor it wraps
+*/
+struct AnyBranchPredictor {
+    void *predictor;
+    bool (*predictFn)(void *, uint32_t);
+    void (*updateFn)(void *, uint32_t, bool);
+    void (*destroyFn)(void *);
+    void (*sizeFn)(void *, CheckpointSize &);
+    void (*saveFn)(void *, CheckpointWriter &);
+    void (*restoreFn)(void *, CheckpointReader &);
+
+    template <class Derived>
+    AnyBranchPredictor(BranchPredictor<Derived> *base) : predictor(&base->self()) {
+        predictFn = [](void *p, uint32_t pc) { return static_cast<Derived *>(p)->predict(pc); };
+        updateFn = [](void *p, uint32_t pc, bool taken) { static_cast<Derived *>(p)->update(pc, taken); };
+        destroyFn = [](void *p) { delete static_cast<Derived *>(p); };
+        sizeFn = [](void *p, CheckpointSize &archive) { static_cast<Derived *>(p)->checkpointState(archive); };
+        saveFn = [](void *p, CheckpointWriter &archive) { static_cast<Derived *>(p)->checkpointState(archive); };
+        restoreFn = [](void *p, CheckpointReader &archive) { static_cast<Derived *>(p)->checkpointState(archive); };
+    }
+    AnyBranchPredictor(const AnyBranchPredictor &) = delete;
+    AnyBranchPredictor &operator=(const AnyBranchPredictor &) = delete;
+    ~AnyBranchPredictor() { destroyFn(predictor); }
+
+    bool predict(uint32_t pc) { return predictFn(predictor, pc); }
+    void update(uint32_t pc, bool taken) { updateFn(predictor, pc, taken); }
+    void checkpointState(CheckpointSize &archive) { sizeFn(predictor, archive); }
+    void checkpointState(CheckpointWriter &archive) { saveFn(predictor, archive); }
+    void checkpointState(CheckpointReader &archive) { restoreFn(predictor, archive); }
 };
 
-// alternate logic for struct SaturatingBHRBranchPredictor : public BranchPredictor {
+/*
+    hand visit a new predictor of the type named on the command line, counters start weakly not taken;
+    false for an unknown name or size. The sizes are log2 of the table entries:
+        saturating, bhr, saturating-bhr         fixed sizes
+        gshare[:<bits>[:<history bits>]]        default 14, history as many bits as the index
+        tournament[:<bits>]                     default 14, for each of the three tables
+        tage[:<bits>]                           default 10, for the base and each tagged table
+*/
+template <class Visitor>
+bool withPredictor(const std::string &name, Visitor &&visit) {
+    std::string kind = name.substr(0, name.find(':'));
+    std::vector<int> sizes;
+    for (size_t colon = name.find(':'); colon != std::string::npos; colon = name.find(':', colon + 1)) {
+        size_t end = name.find(':', colon + 1);
+        std::string field = name.substr(colon + 1, end == std::string::npos ? std::string::npos : end - colon - 1);
+        if (field.empty() || field.size() > 2 || field.find_first_not_of("0123456789") != std::string::npos)
+            return false;
+        sizes.push_back(std::stoi(field));
+        if (sizes.back() < 1 || sizes.back() > 24)
+            return false;
+    }
+    auto size = [&](size_t i, int fallback) { return i < sizes.size() ? sizes[i] : fallback; };
+    if (kind == "saturating" && sizes.empty())
+        visit(new SaturatingBranchPredictor(1));
+    else if (kind == "bhr" && sizes.empty())
+        visit(new BHRBranchPredictor(1));
+    else if (kind == "saturating-bhr" && sizes.empty())
+        visit(new SaturatingBHRBranchPredictor(1, 1 << 16));
+    else if (kind == "gshare" && sizes.size() <= 2 && size(1, size(0, 14)) <= size(0, 14))
+        visit(new GShareBranchPredictor(1, size(0, 14), size(1, size(0, 14))));
+    else if (kind == "tournament" && sizes.size() <= 1)
+        visit(new TournamentBranchPredictor(1, size(0, 14)));
+    else if (kind == "tage" && sizes.size() <= 1 && size(0, 10) >= TageBranchPredictor::TABLES)
+        visit(new TageBranchPredictor(1, size(0, 10)));
+    else
+        return false;
+    return true;
+}
+
+inline AnyBranchPredictor *makePredictor(const std::string &name) {
+    AnyBranchPredictor *any = nullptr;
+    withPredictor(name, [&](auto *predictor) { any = new AnyBranchPredictor(predictor); });
+    return any;
+}
+
+// alternate logic for struct SaturatingBHRBranchPredictor : public BranchPredictor<SaturatingBHRBranchPredictor> {
 //     std::vector<std::bitset<2>> bhrTable;
 //     std::bitset<2> bhr;
 //     std::vector<std::bitset<2>> table;
@@ -0,0 +1,98 @@
+#ifndef __BRANCH_TARGET_HPP__
+#define __BRANCH_TARGET_HPP__
+
+#include <vector>
+#include <cstdint>
+#include <string>
+
+/*
+    set associative branch target buffer consulted by IF: sets (a power of two) x ways entries with LRU replacement,
+    each holding the pc (0-based) and target (0-based) of a control instruction that was taken and whether it is a
+    conditional branch; the arrays are kept apart so that a lookup only walks the tags of one set
+    disabled (no sets) the pipeline knows every target at fetch, as if the buffer were perfect
+*/
+struct BranchTargetBuffer{
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+
+    uint32_t sets = 0, ways = 0;
+    std::vector<uint32_t> tags;
+    std::vector<int> targets;
+    std::vector<uint8_t> conditional;
+    std::vector<uint32_t> used;     // LRU stamps
+    uint32_t clock = 0;
+    long long lookups = 0, hits = 0;
+
+    void resize(uint32_t setCount, uint32_t wayCount)
+    {
+        sets = setCount;
+        ways = wayCount;
+        tags.assign(sets * ways, EMPTY);
+        targets.assign(sets * ways, 0);
+        conditional.assign(sets * ways, 0);
+        used.assign(sets * ways, 0);
+    }
+
+    bool enabled() const
+    {
+        return sets != 0;
+    }
+
+    // configuration a checkpoint of the buffer can be restored onto
+    std::string signature() const
+    {
+        return std::to_string(sets) + 'x' + std::to_string(ways);
+    }
+
+    template <class Archive>
+    void checkpointState(Archive &archive)
+    {
+        archive(tags);
+        archive(targets);
+        archive(conditional);
+        archive(used);
+        archive(clock);
+        archive(lookups);
+        archive(hits);
+    }
+
+    // way of pc within its set starting at base, -1 on a miss
+    int find(uint32_t base, uint32_t pc) const
+    {
+        for (uint32_t way = 0; way < ways; ++way)
+            if (tags[base + way] == pc)
+                return way;
+        return -1;
+    }
+
+    bool lookup(uint32_t pc, int &target, bool &branch)
+    {
+        uint32_t base = (pc & (sets - 1)) * ways;
+        int way = find(base, pc);
+        if (way < 0)
+            return false;
+        used[base + way] = ++clock;
+        target = targets[base + way];
+        branch = conditional[base + way];
+        return true;
+    }
+
+    // record a taken control instruction, evicting the least recently used way of its set
+    void insert(uint32_t pc, int target, bool branch)
+    {
+        uint32_t base = (pc & (sets - 1)) * ways;
+        int way = find(base, pc);
+        if (way < 0)
+        {
+            way = 0;
+            for (uint32_t i = 1; i < ways; ++i)
+                if (used[base + i] < used[base + way])
+                    way = i;
+            tags[base + way] = pc;
+        }
+        targets[base + way] = target;
+        conditional[base + way] = branch;
+        used[base + way] = ++clock;
+    }
+};
+
+#endif
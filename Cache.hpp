@@ -0,0 +1,206 @@
+#ifndef __CACHE_HPP__
+#define __CACHE_HPP__
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <cstdint>
+
+/*
+    configuration of one L1 cache, given on the command line as
+        <size>:<ways>:<line>:<miss latency>[:lru | :plru][:write-back | :write-through]
+    size and line in bytes, size / (ways * line) sets; sets, ways and line powers of two (plru needs at most 64 ways)
+    the miss latency is in cycles, at most 1000000
+    write-back allocates on a write miss, write-through does not and writes never stall (a write buffer is assumed)
+*/
+struct CacheConfig{
+    // a miss with a dirty victim stalls twice the latency, which has to fit an int
+    static const int MAX_LATENCY = 1000000;
+
+    uint32_t size = 0, ways = 0, line = 0;
+    int latency = 0;
+    bool plru = false, writeThrough = false;
+};
+
+inline bool parseCacheConfig(const std::string &spec, CacheConfig &config)
+{
+    std::istringstream fields(spec);
+    std::string field;
+    std::vector<std::string> parts;
+    while (getline(fields, field, ':'))
+        parts.push_back(field);
+    if (parts.size() < 4)
+        return false;
+    long long values[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        if (parts[i].empty() || parts[i].size() > 9 || parts[i].find_first_not_of("0123456789") != std::string::npos)
+            return false;
+        values[i] = std::stoll(parts[i]);
+    }
+    config.size = values[0];
+    config.ways = values[1];
+    config.line = values[2];
+    config.latency = values[3];
+    for (size_t i = 4; i < parts.size(); ++i)
+    {
+        if (parts[i] == "lru" || parts[i] == "plru")
+            config.plru = parts[i] == "plru";
+        else if (parts[i] == "write-back" || parts[i] == "write-through")
+            config.writeThrough = parts[i] == "write-through";
+        else
+            return false;
+    }
+    auto power = [](uint64_t v) { return v && !(v & (v - 1)); };
+    // bytes of one set, in 64 bits as ways * line overflows 32
+    uint64_t set = (uint64_t)config.ways * config.line;
+    return power(config.ways) && power(config.line) && config.line >= 4 && config.size <= (1u << 24) &&
+           set && set <= config.size && config.size % set == 0 && power(config.size / set) &&
+           !(config.plru && config.ways > 64) && config.latency <= CacheConfig::MAX_LATENCY;
+}
+
+/*
+    set associative cache of tags only (the data stays in the pipeline's memory), all arrays indexed by
+    set * ways + way so that a lookup walks the tags of one set contiguously
+    LRU keeps a use stamp per way; tree PLRU keeps ways - 1 bits per set, bit i having children 2i + 1 and 2i + 2
+    and pointing to the right subtree when set
+*/
+struct Cache{
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+
+    CacheConfig config;
+    uint32_t sets = 0, lineShift = 0;
+    std::vector<uint32_t> tags;
+    std::vector<uint8_t> dirty;
+    std::vector<uint32_t> used;     // LRU stamps
+    std::vector<uint64_t> tree;     // PLRU bits, one word per set
+    uint32_t clock = 0;
+    long long reads = 0, writes = 0, readMisses = 0, writeMisses = 0, writebacks = 0, stallCycles = 0;
+
+    void configure(const CacheConfig &cacheConfig)
+    {
+        config = cacheConfig;
+        sets = config.size / ((uint64_t)config.ways * config.line);
+        for (lineShift = 0; (1u << lineShift) < config.line; ++lineShift)
+            ;
+        tags.assign(sets * config.ways, EMPTY);
+        dirty.assign(sets * config.ways, 0);
+        used.assign(sets * config.ways, 0);
+        tree.assign(sets, 0);
+    }
+
+    bool enabled() const
+    {
+        return sets != 0;
+    }
+
+    // configuration a checkpoint of the cache can be restored onto
+    std::string signature() const
+    {
+        std::ostringstream text;
+        text << config.size << ':' << config.ways << ':' << config.line << ':' << config.latency << ':'
+             << (config.plru ? "plru" : "lru") << ':' << (config.writeThrough ? "write-through" : "write-back");
+        return text.str();
+    }
+
+    template <class Archive>
+    void checkpointState(Archive &archive)
+    {
+        archive(tags);
+        archive(dirty);
+        archive(used);
+        archive(tree);
+        archive(clock);
+        archive(reads);
+        archive(writes);
+        archive(readMisses);
+        archive(writeMisses);
+        archive(writebacks);
+        archive(stallCycles);
+    }
+
+    // mark way as the most recently used of its set
+    void touch(uint32_t set, uint32_t way)
+    {
+        if (!config.plru)
+        {
+            used[set * config.ways + way] = ++clock;
+            return;
+        }
+        // walk from the leaf up, pointing every node on the path away from way
+        uint64_t &bits = tree[set];
+        for (uint32_t node = way + config.ways - 1; node; node = (node - 1) / 2)
+        {
+            uint32_t parent = (node - 1) / 2;
+            if (node == 2 * parent + 1)
+                bits |= 1ull << parent;
+            else
+                bits &= ~(1ull << parent);
+        }
+    }
+
+    uint32_t victim(uint32_t set) const
+    {
+        uint32_t base = set * config.ways;
+        for (uint32_t way = 0; way < config.ways; ++way)
+            if (tags[base + way] == EMPTY)
+                return way;
+        if (!config.plru)
+        {
+            uint32_t oldest = 0;
+            for (uint32_t way = 1; way < config.ways; ++way)
+                if (used[base + way] < used[base + oldest])
+                    oldest = way;
+            return oldest;
+        }
+        uint32_t node = 0;
+        while (node < config.ways - 1)
+            node = 2 * node + 1 + ((tree[set] >> node) & 1);
+        return node - (config.ways - 1);
+    }
+
+    // access the byte address, returning the cycles the pipeline stalls for
+    int access(uint32_t address, bool write)
+    {
+        uint32_t block = address >> lineShift, set = block & (sets - 1), base = set * config.ways;
+        write ? ++writes : ++reads;
+        for (uint32_t way = 0; way < config.ways; ++way)
+        {
+            if (tags[base + way] == block)
+            {
+                dirty[base + way] |= write && !config.writeThrough;
+                touch(set, way);
+                return 0;
+            }
+        }
+        write ? ++writeMisses : ++readMisses;
+        if (write && config.writeThrough)
+            return 0;
+        uint32_t way = victim(set);
+        int stall = config.latency;
+        if (tags[base + way] != EMPTY && dirty[base + way])
+        {
+            ++writebacks;
+            stall += config.latency;
+        }
+        tags[base + way] = block;
+        dirty[base + way] = write;
+        touch(set, way);
+        stallCycles += stall;
+        return stall;
+    }
+
+    void printStats(const char *name) const
+    {
+        long long accesses = reads + writes, misses = readMisses + writeMisses;
+        std::cerr << name << " accesses: " << accesses << '\n'
+                  << name << " misses: " << misses << " (" << readMisses << " read, " << writeMisses << " write)\n";
+        if (accesses)
+            std::cerr << name << " hit rate: " << 100.0 * (accesses - misses) / accesses << "%\n";
+        std::cerr << name << " writebacks: " << writebacks << '\n'
+                  << name << " stall cycles: " << stallCycles << '\n';
+    }
+};
+
+#endif
@@ -0,0 +1,259 @@
+#ifndef __CHECKPOINT_HPP__
+#define __CHECKPOINT_HPP__
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Memory.hpp"
+
+/*
+    checkpoint file of a pipelined run, in the byte order and struct layout of the build that wrote it:
+        CheckpointHeader
+        state block     the fields listed by MIPS_Pipeline::checkpointState back to back, stateSize bytes
+        sections        predictor, branch target buffer, I-cache and D-cache state, each as the signature of its
+                        configuration (uint64 length and text), the body length (uint64) and the body; a section
+                        is only restored onto the same configuration and skipped otherwise (the structure starts cold)
+        pages           the words below address 0 and their delta bits, padding to 8 bytes, page count (uint64),
+                        then for every page written so far its index (uint64) followed by the raw PagedMemory::Page,
+                        words and delta bitmap
+    restoring maps the file privately and adopts the pages right where they lie: nothing is copied, and the kernel
+    copies a page only once the resumed run writes to it
+*/
+static const char CHECKPOINT_MAGIC[16] = "MIPSCKP1";
+
+struct CheckpointHeader{
+    char magic[16];
+    char model[16];         // hazard policy NAME
+    uint64_t program;       // fingerprint of the program text
+    uint32_t fetch;         // fetch scheme, see MIPS_Pipeline::fetchScheme
+    uint32_t stateSize;
+};
+
+enum CheckpointStatus{
+    CHECKPOINT_OK = 0,
+    CHECKPOINT_UNREADABLE,
+    CHECKPOINT_MODEL,
+    CHECKPOINT_PROGRAM,
+    CHECKPOINT_FETCH
+};
+
+inline const char *checkpointError(CheckpointStatus status)
+{
+    static const char *const messages[] = {"", "Checkpoint could not be read", "Checkpoint was taken with another model",
+                                           "Checkpoint was taken on another program",
+                                           "Checkpoint was taken with another fetch scheme (--predictor, --btb, --early-branch)"};
+    return messages[status];
+}
+
+/*
+    archives walk the state of an object through a checkpointState(archive) member listing its fields as
+    archive(field), a field being trivially copyable or a vector of trivially copyable elements (stored as its
+    uint64 size and elements); CheckpointSize counts the bytes, CheckpointWriter and CheckpointReader move them
+*/
+struct CheckpointSize{
+    size_t size = 0;
+
+    template <class T>
+    void operator()(const T &)
+    {
+        size += sizeof(T);
+    }
+
+    template <class T>
+    void operator()(const std::vector<T> &values)
+    {
+        size += sizeof(uint64_t) + values.size() * sizeof(T);
+    }
+};
+
+struct CheckpointWriter{
+    FILE *file = nullptr;
+    size_t offset = 0;
+    bool ok = false;
+
+    bool open(const std::string &path)
+    {
+        file = std::fopen(path.c_str(), "wb");
+        return ok = file != nullptr;
+    }
+
+    void put(const void *bytes, size_t size)
+    {
+        ok = ok && std::fwrite(bytes, 1, size, file) == size;
+        offset += size;
+    }
+
+    template <class T>
+    void operator()(const T &value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "checkpointed state must be trivially copyable");
+        put(&value, sizeof(T));
+    }
+
+    template <class T>
+    void operator()(const std::vector<T> &values)
+    {
+        (*this)((uint64_t)values.size());
+        put(values.data(), values.size() * sizeof(T));
+    }
+
+    template <class State>
+    void section(const std::string &signature, State &&state)
+    {
+        CheckpointSize size;
+        state(size);
+        (*this)((uint64_t)signature.size());
+        put(signature.data(), signature.size());
+        (*this)((uint64_t)size.size);
+        state(*this);
+    }
+
+    void align()
+    {
+        static const char zeros[8] = {0};
+        put(zeros, (8 - offset % 8) % 8);
+    }
+
+    bool close()
+    {
+        if (file && std::fclose(file))
+            ok = false;
+        file = nullptr;
+        return ok;
+    }
+};
+
+// reads a checkpoint mapped privately into memory
+struct CheckpointReader{
+    std::shared_ptr<void> mapping;  // unmapped once the last adopted page is released
+    unsigned char *base = nullptr, *pos = nullptr, *end = nullptr;
+    bool ok = false;
+
+    bool open(const std::string &path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) < 0 || st.st_size == 0)
+        {
+            if (fd >= 0)
+                close(fd);
+            return false;
+        }
+        size_t size = st.st_size;
+        void *mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED)
+            return false;
+        mapping = std::shared_ptr<void>(mapped, [size](void *p)
+                                        { munmap(p, size); });
+        base = pos = (unsigned char *)mapped;
+        end = base + size;
+        return ok = true;
+    }
+
+    void get(void *bytes, size_t size)
+    {
+        ok = ok && (size_t)(end - pos) >= size;
+        if (!ok)
+            return;
+        std::memcpy(bytes, pos, size);
+        pos += size;
+    }
+
+    template <class T>
+    void operator()(T &value)
+    {
+        get(&value, sizeof(T));
+    }
+
+    template <class T>
+    void operator()(std::vector<T> &values)
+    {
+        uint64_t size = 0;
+        (*this)(size);
+        ok = ok && size <= (uint64_t)(end - pos) / sizeof(T);
+        if (!ok)
+            return;
+        values.resize(size);
+        get(values.data(), size * sizeof(T));
+    }
+
+    // restore the section through state if it was written for signature, true if it was
+    template <class State>
+    bool section(const std::string &signature, State &&state)
+    {
+        uint64_t length = 0, body = 0;
+        (*this)(length);
+        ok = ok && length <= (uint64_t)(end - pos);
+        if (!ok)
+            return false;
+        bool match = signature == std::string((const char *)pos, length);
+        pos += length;
+        (*this)(body);
+        ok = ok && body <= (uint64_t)(end - pos);
+        if (!ok)
+            return false;
+        unsigned char *next = pos + body;
+        if (match)
+        {
+            state(*this);
+            ok = ok && pos == next;
+        }
+        pos = next;
+        return match;
+    }
+
+    void align()
+    {
+        pos = base + ((pos - base + 7) & ~(size_t)7);
+        ok = ok && pos <= end;
+    }
+};
+
+inline void writePages(CheckpointWriter &writer, const PagedMemory &memory)
+{
+    uint64_t count = 0;
+    for (auto page : memory.pages)
+        count += page != nullptr;
+    writer(memory.outside);
+    writer(memory.outsideDelta);
+    writer.align();
+    writer(count);
+    for (uint64_t index = 0; index < memory.pages.size(); ++index)
+        if (memory.pages[index])
+        {
+            writer(index);
+            writer(*memory.pages[index]);
+        }
+}
+
+// adopt the pages of the checkpoint into memory, which must not have any page yet
+inline bool readPages(CheckpointReader &reader, PagedMemory &memory)
+{
+    uint64_t count = 0, index;
+    reader(memory.outside);
+    reader(memory.outsideDelta);
+    memory.deltaSize += __builtin_popcount(memory.outsideDelta);
+    reader.align();
+    reader(count);
+    for (uint64_t i = 0; i < count && reader.ok; ++i)
+    {
+        reader(index);
+        if ((size_t)(reader.end - reader.pos) < sizeof(PagedMemory::Page) || index >= memory.pages.size())
+            return false;
+        memory.adopt(index, (PagedMemory::Page *)reader.pos);
+        reader.pos += sizeof(PagedMemory::Page);
+    }
+    memory.backing = reader.mapping;
+    return reader.ok;
+}
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef __FUNCTIONAL_HPP__
+#define __FUNCTIONAL_HPP__
+
+#include "Instruction.hpp"
+
+// outcome of a functional run: instructions executed and the exit code (SUCCESS unless an error stopped it)
+struct FunctionalResult{
+    long long instructions = 0;
+    int exitCode = 0;
+};
+
+/*
+    functional interpreter over the architectural state of a simulator (registers, data and its delta)
+    executes the decoded program back to back starting at pc (0-based) until it runs off the end of the
+    program or limit instructions have executed, leaving pc at the next instruction to execute
+    error codes follow MIPS_Architecture::exit_code: 2 for a bad label, 3 for a bad address, 4 for a malformed instruction
+    on an error pc is left at the offending instruction
+*/
+template <class Architecture>
+FunctionalResult executeFunctional(Architecture &mips, int &pc, long long limit = -1)
+{
+    FunctionalResult result;
+    const Instruction *program = mips.program.data();
+    const int size = mips.program.size(), lowest = 4 * size;
+    int *registers = mips.registers;
+    while (pc < size && result.instructions != limit)
+    {
+        const Instruction &inst = program[pc];
+        switch (inst.op)
+        {
+        case OP_ADD:
+            registers[inst.rd] = ALU::add(registers[inst.rs], registers[inst.rt]);
+            ++pc;
+            break;
+        case OP_SUB:
+            registers[inst.rd] = ALU::sub(registers[inst.rs], registers[inst.rt]);
+            ++pc;
+            break;
+        case OP_MUL:
+            registers[inst.rd] = ALU::mul(registers[inst.rs], registers[inst.rt]);
+            ++pc;
+            break;
+        case OP_SLT:
+            registers[inst.rd] = ALU::slt(registers[inst.rs], registers[inst.rt]);
+            ++pc;
+            break;
+        case OP_ADDI:
+            if (inst.flags & BAD_OPERAND)
+            {
+                result.exitCode = 4;
+                return result;
+            }
+            registers[inst.rd] = ALU::add(registers[inst.rs], inst.imm);
+            ++pc;
+            break;
+        case OP_BEQ:
+        case OP_BNE:
+        case OP_J:
+            if (inst.target < 0)
+            {
+                // a label defined more than once
+                result.exitCode = 2;
+                return result;
+            }
+            if (inst.op == OP_J)
+                pc = inst.target;
+            else
+            {
+                bool taken = (registers[inst.rs] == registers[inst.rt]) == (inst.op == OP_BEQ);
+                mips.branchTrace.record(pc, taken);
+                pc = taken ? inst.target : pc + 1;
+            }
+            break;
+        case OP_LW:
+        case OP_SW:
+        {
+            if (inst.flags & (BAD_OPERAND | MEM_ABS_BAD))
+            {
+                result.exitCode = 4;
+                return result;
+            }
+            // a base register that did not decode is an invalid address, as in MIPS_Pipeline::locateAddress
+            bool badBase = (inst.flags & MEM_PAREN) && !(inst.flags & RS_VALID);
+            int address = inst.flags & MEM_PAREN ? registers[inst.rs] + inst.imm : inst.imm;
+            if (badBase || address % 4 || address < lowest || address >= Architecture::MAX)
+            {
+                result.exitCode = 3;
+                return result;
+            }
+            address /= 4;
+            if (inst.op == OP_LW)
+                registers[inst.rd] = mips.data.read(address);
+            else
+                mips.data.write(address, registers[inst.rt]);
+            ++pc;
+            break;
+        }
+        default:
+            result.exitCode = 4;
+            return result;
+        }
+        ++result.instructions;
+    }
+    return result;
+}
+
+#endif
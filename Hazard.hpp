@@ -0,0 +1,431 @@
+#ifndef __HAZARD_HPP__
+#define __HAZARD_HPP__
+
+#include <climits>
+#include "Pipeline.hpp"
+
+/*
+    hazard policies of MIPS_Pipeline, all hooks are static so that every configuration is specialised at compile time:
+    NAME                 name of the model, as in batch manifests and checkpoints
+    PENDING              extract of an instruction whose result has not been produced yet
+    ALL_TO_WB            whether instructions completed in MEM (sw, branches) still move on to WB
+    decode(mips, inst, id_ex)
+                         read the operands of the instruction in ID into id_ex and record its dependencies
+    ready(mips)          whether the instruction in ID may move on to EX once decoded, stall(mips) is called otherwise
+    blocker(mips, inst)  the producer the instruction in ID is held by while not ready, for the stall accounting
+    canExecute(mips)     whether EX runs this cycle
+    canDecode(mips)      whether ID and IF run this cycle
+    executed(mips, id, value), accessed(mips, id, value)
+                         the result of id as produced in EX (ALU results) and in MEM (loaded or stored values)
+*/
+
+// Types = {{"add", 0}, {"sub", 0}, {"mul", 0}, {"beq", 1}, {"bne", 1}, {"slt", 0}, {"j", 4}, {"lw", 2}, {"sw", 2}, {"addi", 3}};
+
+// no forwarding: an instruction waits in ID until its youngest producer has completed
+struct NoBypass{
+    static constexpr const char *NAME = "nobypass";
+    static const int PENDING = 0;
+    static const bool ALL_TO_WB = false;
+
+    // make the instruction wait on the youngest producer of rs and rt, leaving it alone when neither has one
+    template <class Core>
+    static inline void depend(Core &mips, int &dependinst, int rs, int rt){
+        if (mips.dependreg[rs]){
+            dependinst = mips.dependreg[rs];
+            if ((mips.dependreg[rt])&&(dependinst < mips.dependreg[rt])){
+                dependinst = mips.dependreg[rt];
+            }
+        }
+        else if (mips.dependreg[rt]){
+            dependinst = mips.dependreg[rt];
+        }
+    }
+
+    template <class Core>
+    static void decode(Core &mips, const Instruction &inst, ID_EX &id_ex){
+        int id = mips.pipeline.count[STAGE_ID];
+        int &dependinst = mips.scoreboard[id].dependinst;
+        switch(inst.type){
+            case 0:
+                depend(mips, dependinst, inst.rs, inst.rt);
+                if (ready(mips)){
+                    id_ex.opcode = inst.op;
+                    id_ex.ReadData1 = mips.registers[inst.rs];
+                    id_ex.ReadData2 = mips.registers[inst.rt];
+                    id_ex.adder = 0;
+                    id_ex.rd = inst.rd;
+                    mips.dependreg[id_ex.rd] = id;
+                }
+                break;
+            case 1:
+                depend(mips, dependinst, inst.rs, inst.rt);
+                if (ready(mips)){
+                    id_ex.opcode = inst.op;
+                    id_ex.ReadData1 = mips.registers[inst.rs];
+                    id_ex.ReadData2 = mips.registers[inst.rt];
+                    id_ex.adder = inst.target;
+                    mips.branchinst = id;
+                    id_ex.rd = 0;
+                    if (mips.earlyBranch){
+                        mips.resolveEarly(id_ex);
+                    }
+                }
+                break;
+            case 2:
+                checkOperands(inst);
+                if (inst.op == OP_LW){
+                    depend(mips, dependinst, inst.rs, inst.rs);
+                }
+                else{
+                    depend(mips, dependinst, inst.rt, inst.rs);
+                }
+                if (ready(mips)){
+                    id_ex.opcode = inst.op;
+                    id_ex.ReadData1 = 0;
+                    id_ex.ReadData2 = mips.registers[inst.rt];
+                    id_ex.adder = mips.locateAddress(inst, mips.registers[inst.rs]);
+                    if (inst.op == OP_LW){
+                        id_ex.rd = inst.rd;
+                        mips.dependreg[id_ex.rd] = id;
+                    }
+                }
+                break;
+            case 3:
+                depend(mips, dependinst, inst.rs, inst.rs);
+                if (ready(mips)){
+                    checkOperands(inst);
+                    id_ex.opcode = inst.op;
+                    id_ex.ReadData1 = mips.registers[inst.rs];
+                    id_ex.ReadData2 = inst.imm;
+                    id_ex.adder = 0;
+                    id_ex.rd = inst.rd;
+                    mips.dependreg[id_ex.rd] = id;
+                }
+                break;
+            case 4:
+                id_ex.opcode = inst.op;
+                id_ex.ReadData1 = 0;
+                id_ex.ReadData2 = 0;
+                id_ex.adder = inst.target;
+                mips.branchinst = id;
+                id_ex.rd = 0;
+                if (mips.earlyBranch){
+                    mips.resolveEarly(id_ex);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    template <class Core>
+    static inline bool ready(Core &mips){
+        int dependinst = mips.scoreboard[mips.pipeline.count[STAGE_ID]].dependinst;
+        return (dependinst == 0)||(mips.scoreboard[dependinst].completed);
+    }
+
+    template <class Core>
+    static inline int blocker(Core &mips, const Instruction &){
+        return mips.scoreboard[mips.pipeline.count[STAGE_ID]].dependinst;
+    }
+
+    template <class Core>
+    static inline void stall(Core &){}
+
+    template <class Core>
+    static inline bool canExecute(Core &){
+        return true;
+    }
+
+    // a stalled instruction holds ID and IF
+    template <class Core>
+    static inline bool canDecode(Core &mips){
+        return ready(mips);
+    }
+
+    template <class Core>
+    static inline void executed(Core &, int, int){}
+
+    template <class Core>
+    static inline void accessed(Core &, int, int){}
+};
+
+/*
+    full forwarding: ID reads the latest value produced for a register from the scoreboard, be it an ALU result
+    from EX or a loaded value from MEM; an operand that is still PENDING freezes EX, ID and IF
+*/
+struct FullBypass{
+    static constexpr const char *NAME = "bypass";
+    static const int PENDING = INT_MAX;
+    static const bool ALL_TO_WB = true;
+
+    // value of register r as last produced in the pipeline, or the register file once its producer has retired
+    template <class Core>
+    static inline int forward(Core &mips, int r){
+        if ((mips.dependreg[r])&&(mips.scoreboard.tracks(mips.dependreg[r]))){
+            int value = mips.scoreboard[mips.dependreg[r]].extract;
+            if (value != PENDING){
+                mips.forwarded(mips.dependreg[r]);
+            }
+            return value;
+        }
+        return mips.registers[r];
+    }
+
+    template <class Core>
+    static inline int read(Core &mips, int r, bool valid){
+        return valid ? forward(mips, r) : 0;
+    }
+
+    template <class Core>
+    static void decode(Core &mips, const Instruction &inst, ID_EX &id_ex){
+        int id = mips.pipeline.count[STAGE_ID];
+        switch(inst.type){
+            case 0:
+                id_ex.opcode = inst.op;
+                id_ex.ReadData1 = read(mips, inst.rs, inst.flags & RS_VALID);
+                id_ex.ReadData2 = read(mips, inst.rt, inst.flags & RT_VALID);
+                id_ex.adder = 0;
+                id_ex.rd = inst.rd;
+                mips.dependreg[id_ex.rd] = id;
+                break;
+            case 1:
+                id_ex.opcode = inst.op;
+                id_ex.ReadData1 = read(mips, inst.rs, inst.flags & RS_VALID);
+                id_ex.ReadData2 = read(mips, inst.rt, inst.flags & RT_VALID);
+                id_ex.adder = inst.target;
+                mips.branchinst = id;
+                id_ex.rd = 0;
+                if ((mips.earlyBranch)&&(id_ex.ReadData1 != PENDING)&&(id_ex.ReadData2 != PENDING)){
+                    mips.resolveEarly(id_ex);
+                }
+                break;
+            case 2:
+                id_ex.opcode = inst.op;
+                id_ex.ReadData1 = 0;
+                id_ex.ReadData2 = read(mips, inst.rt, (inst.flags & RT_VALID)&&(inst.op == OP_SW));
+                checkOperands(inst);
+                id_ex.adder = mips.locateAddress(inst, read(mips, inst.rs, inst.flags & RS_VALID));
+                if (inst.op == OP_LW){
+                    id_ex.rd = inst.rd;
+                    mips.dependreg[id_ex.rd] = id;
+                }
+                break;
+            case 3:
+                id_ex.opcode = inst.op;
+                id_ex.ReadData1 = read(mips, inst.rs, inst.flags & RS_VALID);
+                checkOperands(inst);
+                id_ex.ReadData2 = inst.imm;
+                id_ex.adder = 0;
+                id_ex.rd = inst.rd;
+                mips.dependreg[id_ex.rd] = id;
+                break;
+            case 4:
+                id_ex.opcode = inst.op;
+                id_ex.ReadData1 = 0;
+                id_ex.ReadData2 = 0;
+                id_ex.adder = inst.target;
+                mips.branchinst = id;
+                id_ex.rd = 0;
+                if (mips.earlyBranch){
+                    mips.resolveEarly(id_ex);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    template <class Core>
+    static inline bool ready(Core &mips){
+        return !((mips.pipeline.id_ex.ReadData1 == PENDING)||(mips.pipeline.id_ex.ReadData2 == PENDING));
+    }
+
+    // the latest earlier producer of an operand whose value is still PENDING, a lw as ALU results are known in EX
+    template <class Core>
+    static inline int blocker(Core &mips, const Instruction &inst){
+        int producer = 0;
+        for (int r : {inst.rs, inst.rt}){
+            int id = mips.dependreg[r];
+            if ((id)&&(id < mips.pipeline.count[STAGE_ID])&&(mips.scoreboard.tracks(id))&&(mips.scoreboard[id].extract == PENDING)&&(producer < id)){
+                producer = id;
+            }
+        }
+        return producer;
+    }
+
+    template <class Core>
+    static inline void stall(Core &mips){
+        mips.pipeline.count[STAGE_EX] = -1;
+    }
+
+    template <class Core>
+    static inline bool canExecute(Core &mips){
+        return mips.pipeline.count[STAGE_EX] != -1;
+    }
+
+    template <class Core>
+    static inline bool canDecode(Core &mips){
+        return mips.pipeline.count[STAGE_EX] != -1;
+    }
+
+    template <class Core>
+    static inline void executed(Core &mips, int id, int value){
+        mips.scoreboard[id].extract = value;
+    }
+
+    template <class Core>
+    static inline void accessed(Core &mips, int id, int value){
+        mips.scoreboard[id].extract = value;
+    }
+};
+
+/*
+    forwarding from EX only: ALU results can be read in ID as soon as they leave EX, while loaded values have to be
+    written back first, so an instruction using the result of a lw waits in ID as it would without forwarding
+*/
+struct EXBypass{
+    static constexpr const char *NAME = "exbypass";
+    static const int PENDING = INT_MAX;
+    static const bool ALL_TO_WB = false;
+
+    // whether the result of instruction id can be read in ID
+    template <class Core>
+    static inline bool available(Core &mips, int id){
+        return (id == 0)||(mips.scoreboard[id].completed)||(mips.scoreboard[id].extract != PENDING);
+    }
+
+    // make the instruction wait on the producer of r if its result cannot be read yet
+    template <class Core>
+    static inline void depend(Core &mips, int &dependinst, int r){
+        int producer = mips.dependreg[r];
+        if ((!available(mips, producer))&&(dependinst < producer)){
+            dependinst = producer;
+        }
+    }
+
+    template <class Core>
+    static inline int read(Core &mips, int r){
+        int producer = mips.dependreg[r];
+        if ((producer)&&(!mips.scoreboard[producer].completed)){
+            mips.forwarded(producer);
+            return mips.scoreboard[producer].extract;
+        }
+        return mips.registers[r];
+    }
+
+    template <class Core>
+    static void decode(Core &mips, const Instruction &inst, ID_EX &id_ex){
+        int id = mips.pipeline.count[STAGE_ID];
+        int &dependinst = mips.scoreboard[id].dependinst;
+        dependinst = 0;
+        switch(inst.type){
+            case 0:
+                depend(mips, dependinst, inst.rs);
+                depend(mips, dependinst, inst.rt);
+                if (dependinst == 0){
+                    id_ex.opcode = inst.op;
+                    id_ex.ReadData1 = read(mips, inst.rs);
+                    id_ex.ReadData2 = read(mips, inst.rt);
+                    id_ex.adder = 0;
+                    id_ex.rd = inst.rd;
+                    mips.dependreg[id_ex.rd] = id;
+                }
+                break;
+            case 1:
+                depend(mips, dependinst, inst.rs);
+                depend(mips, dependinst, inst.rt);
+                if (dependinst == 0){
+                    id_ex.opcode = inst.op;
+                    id_ex.ReadData1 = read(mips, inst.rs);
+                    id_ex.ReadData2 = read(mips, inst.rt);
+                    id_ex.adder = inst.target;
+                    mips.branchinst = id;
+                    id_ex.rd = 0;
+                    if (mips.earlyBranch){
+                        mips.resolveEarly(id_ex);
+                    }
+                }
+                break;
+            case 2:
+                checkOperands(inst);
+                depend(mips, dependinst, inst.rs);
+                if (inst.op == OP_SW){
+                    depend(mips, dependinst, inst.rt);
+                }
+                if (dependinst == 0){
+                    id_ex.opcode = inst.op;
+                    id_ex.ReadData1 = 0;
+                    id_ex.ReadData2 = inst.op == OP_SW ? read(mips, inst.rt) : 0;
+                    id_ex.adder = mips.locateAddress(inst, read(mips, inst.rs));
+                    if (inst.op == OP_LW){
+                        id_ex.rd = inst.rd;
+                        mips.dependreg[id_ex.rd] = id;
+                    }
+                }
+                break;
+            case 3:
+                depend(mips, dependinst, inst.rs);
+                if (dependinst == 0){
+                    checkOperands(inst);
+                    id_ex.opcode = inst.op;
+                    id_ex.ReadData1 = read(mips, inst.rs);
+                    id_ex.ReadData2 = inst.imm;
+                    id_ex.adder = 0;
+                    id_ex.rd = inst.rd;
+                    mips.dependreg[id_ex.rd] = id;
+                }
+                break;
+            case 4:
+                id_ex.opcode = inst.op;
+                id_ex.ReadData1 = 0;
+                id_ex.ReadData2 = 0;
+                id_ex.adder = inst.target;
+                mips.branchinst = id;
+                id_ex.rd = 0;
+                if (mips.earlyBranch){
+                    mips.resolveEarly(id_ex);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    template <class Core>
+    static inline bool ready(Core &mips){
+        return available(mips, mips.scoreboard[mips.pipeline.count[STAGE_ID]].dependinst);
+    }
+
+    template <class Core>
+    static inline int blocker(Core &mips, const Instruction &){
+        return mips.scoreboard[mips.pipeline.count[STAGE_ID]].dependinst;
+    }
+
+    template <class Core>
+    static inline void stall(Core &){}
+
+    template <class Core>
+    static inline bool canExecute(Core &){
+        return true;
+    }
+
+    // a stalled instruction holds ID and IF
+    template <class Core>
+    static inline bool canDecode(Core &mips){
+        return ready(mips);
+    }
+
+    // EX re-runs its instruction while ID stalls, only the first result is the instruction's own
+    template <class Core>
+    static inline void executed(Core &mips, int id, int value){
+        if (mips.scoreboard[id].extract == PENDING){
+            mips.scoreboard[id].extract = value;
+        }
+    }
+
+    template <class Core>
+    static inline void accessed(Core &, int, int){}
+};
+
+#endif
@@ -0,0 +1,270 @@
+#ifndef __INSTRUCTION_HPP__
+#define __INSTRUCTION_HPP__
+
+#include <unordered_map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdexcept>
+#include <cstdint>
+#include <functional>
+
+enum Opcode : uint8_t{
+    OP_ADD = 0,
+    OP_SUB,
+    OP_MUL,
+    OP_BEQ,
+    OP_BNE,
+    OP_SLT,
+    OP_J,
+    OP_LW,
+    OP_SW,
+    OP_ADDI,
+    OP_INVALID
+};
+
+// operand flags of a decoded instruction
+enum OperandFlags : uint8_t{
+    RD_VALID = 1,
+    RS_VALID = 2,
+    RT_VALID = 4,
+    MEM_PAREN = 8,      // memory operand of the form offset($reg)
+    MEM_ABS_BAD = 16,   // absolute memory operand that does not parse
+    BAD_OPERAND = 32    // operand that made the string parser throw
+};
+
+static const char *const mnemonics[OP_INVALID + 1] = {"add", "sub", "mul", "beq", "bne", "slt", "j", "lw", "sw", "addi", ""};
+
+// Types = {{"add", 0}, {"sub", 0}, {"mul", 0}, {"beq", 1}, {"bne", 1}, {"slt", 0}, {"j", 4}, {"lw", 2}, {"sw", 2}, {"addi", 3}};
+static const uint8_t opcodeTypes[OP_INVALID + 1] = {0, 0, 0, 1, 1, 0, 4, 2, 2, 3, 0};
+
+// controlNumbers = {{"add", 0}, {"sub", 0}, {"mul", 0}, {"beq", 3}, {"bne", 3}, {"slt", 0}, {"j", 4}, {"lw", 1}, {"sw", 2}, {"addi", 0}};
+static const uint8_t opcodeControls[OP_INVALID + 1] = {0, 0, 0, 3, 3, 0, 4, 1, 2, 0, 0};
+
+// one parsed line of the program, the mnemonic and three operands (empty when missing) viewing the source text
+struct Command{
+    std::string_view tokens[4];
+
+    std::string_view &operator[](size_t i) { return tokens[i]; }
+    const std::string_view &operator[](size_t i) const { return tokens[i]; }
+    const std::string_view *begin() const { return tokens; }
+    const std::string_view *end() const { return tokens + 4; }
+};
+
+/*
+    decoded form of one line of commands, built once while parsing:
+    R type (add, sub, mul, slt): rd = command[1], rs = command[2], rt = command[3]
+    beq, bne: rs = command[1], rt = command[2], target = label of command[3]
+    lw, sw: rt = command[1] (rd as well for lw), rs = base register, imm = offset (or absolute address)
+    addi: rd = command[1], rs = command[2], imm = command[3]
+    j: target = label of command[1]
+    targets are only resolved by resolveTarget once every label is known
+    unknown registers and labels decode to 0, the same as the default entries the string maps produced
+*/
+struct Instruction{
+    Opcode op;
+    uint8_t type;
+    uint8_t control;
+    uint8_t flags;
+    uint8_t rd;
+    uint8_t rs;
+    uint8_t rt;
+    int imm;
+    int target;
+};
+
+// register names ($0-$31 and their aliases), built once and shared by every simulator instance
+inline const std::unordered_map<std::string, int> &registerNames()
+{
+    static const std::unordered_map<std::string, int> names = []()
+    {
+        std::unordered_map<std::string, int> names;
+        for (int i = 0; i < 32; ++i)
+            names["$" + std::to_string(i)] = i;
+        names["$zero"] = 0;
+        names["$at"] = 1;
+        names["$v0"] = 2;
+        names["$v1"] = 3;
+        for (int i = 0; i < 4; ++i)
+            names["$a" + std::to_string(i)] = i + 4;
+        for (int i = 0; i < 8; ++i)
+            names["$t" + std::to_string(i)] = i + 8, names["$s" + std::to_string(i)] = i + 16;
+        names["$t8"] = 24;
+        names["$t9"] = 25;
+        names["$k0"] = 26;
+        names["$k1"] = 27;
+        names["$gp"] = 28;
+        names["$sp"] = 29;
+        names["$s8"] = 30;
+        names["$ra"] = 31;
+        return names;
+    }();
+    return names;
+}
+
+inline Opcode lookupOpcode(std::string_view mnemonic)
+{
+    for (int i = 0; i < OP_INVALID; ++i)
+        if (mnemonic == mnemonics[i])
+            return (Opcode)i;
+    return OP_INVALID;
+}
+
+inline uint8_t lookupRegister(const std::unordered_map<std::string, int> &registerMap, std::string_view r, uint8_t &flags, uint8_t valid)
+{
+    auto it = registerMap.find(std::string(r));
+    if (it == registerMap.end())
+        return 0;
+    flags |= valid;
+    return it->second;
+}
+
+inline int lookupLabel(const std::unordered_map<std::string, int> &address, std::string_view label)
+{
+    auto it = address.find(std::string(label));
+    return it == address.end() ? 0 : it->second;
+}
+
+// lower one parsed command into its decoded form
+inline Instruction decodeCommand(const Command &command, const std::unordered_map<std::string, int> &registerMap)
+{
+    Instruction inst = {};
+    inst.op = lookupOpcode(command[0]);
+    inst.type = opcodeTypes[inst.op];
+    inst.control = opcodeControls[inst.op];
+    switch (inst.type){
+        case 0:
+            inst.rd = lookupRegister(registerMap, command[1], inst.flags, RD_VALID);
+            inst.rs = lookupRegister(registerMap, command[2], inst.flags, RS_VALID);
+            inst.rt = lookupRegister(registerMap, command[3], inst.flags, RT_VALID);
+            break;
+        case 1:
+            inst.rs = lookupRegister(registerMap, command[1], inst.flags, RS_VALID);
+            inst.rt = lookupRegister(registerMap, command[2], inst.flags, RT_VALID);
+            break;
+        case 2:{
+            inst.rt = lookupRegister(registerMap, command[1], inst.flags, RT_VALID);
+            inst.rd = inst.op == OP_LW ? inst.rt : 0;
+            if (inst.flags & RT_VALID)
+                inst.flags |= RD_VALID;
+            std::string_view location = command[2];
+            try{
+                int lparen = location.find('('), offset = stoi(lparen == 0 ? "0" : std::string(location.substr(0, lparen)));
+                std::string_view reg = location.substr(lparen + 1);
+                reg.remove_suffix(!reg.empty());
+                inst.rs = lookupRegister(registerMap, reg, inst.flags, RS_VALID);
+                if (location.back() == ')'){
+                    inst.flags |= MEM_PAREN;
+                    inst.imm = offset;
+                }
+                else{
+                    try{
+                        inst.imm = stoi(std::string(location));
+                    }
+                    catch (std::exception &e){
+                        inst.flags |= MEM_ABS_BAD;
+                    }
+                }
+            }
+            catch (std::exception &e){
+                inst.flags |= BAD_OPERAND;
+            }
+            break;
+        }
+        case 3:
+            inst.rd = lookupRegister(registerMap, command[1], inst.flags, RD_VALID);
+            inst.rs = lookupRegister(registerMap, command[2], inst.flags, RS_VALID);
+            try{
+                inst.imm = stoi(std::string(command[3]));
+            }
+            catch (std::exception &e){
+                inst.flags |= BAD_OPERAND;
+            }
+            break;
+        default:
+            break;
+    }
+    return inst;
+}
+
+// branch or jump target of a decoded command, looked up once the labels of the whole program are known
+inline void resolveTarget(Instruction &inst, const Command &command, const std::unordered_map<std::string, int> &address)
+{
+    if (inst.type == 1)
+        inst.target = lookupLabel(address, command[3]);
+    else if (inst.type == 4)
+        inst.target = lookupLabel(address, command[1]);
+}
+
+// raised in ID for operands that could not be decoded, as the string parser used to do
+inline void checkOperands(const Instruction &inst)
+{
+    if (inst.flags & BAD_OPERAND)
+        throw std::invalid_argument("stoi");
+}
+
+// ALU kernels, dispatched on the decoded opcode in EX
+struct ALU{
+    //add
+    static constexpr int add(int data1,int data2){
+        return data1 + data2;
+    }
+
+    //sub
+    static constexpr int sub(int data1,int data2){
+        return data1 - data2;
+    }
+
+    //mul
+    static constexpr int mul(int data1,int data2){
+        return data1 * data2;
+    }
+
+    //beq
+    static constexpr int beq(int data1,int data2){
+        return data1 - data2 != 0;
+    }
+
+    //bne
+    static constexpr int bne(int data1,int data2){
+        return data1 - data2 == 0;
+    }
+
+    //slt
+    static constexpr int slt(int data1,int data2){
+        return data1 < data2;
+    }
+
+    //jump
+    static constexpr int j(int,int){
+        return 0;
+    }
+
+    // lw, sw and addi add their operands
+    static inline int execute(Opcode op,int data1,int data2){
+        switch(op){
+            case OP_ADD:
+            case OP_ADDI:
+            case OP_LW:
+            case OP_SW:
+                return add(data1,data2);
+            case OP_SUB:
+                return sub(data1,data2);
+            case OP_MUL:
+                return mul(data1,data2);
+            case OP_BEQ:
+                return beq(data1,data2);
+            case OP_BNE:
+                return bne(data1,data2);
+            case OP_SLT:
+                return slt(data1,data2);
+            case OP_J:
+                return j(data1,data2);
+            default:
+                // unknown mnemonics used to hit an empty std::function
+                throw std::bad_function_call();
+        }
+    }
+};
+
+#endif
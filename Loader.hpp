@@ -0,0 +1,86 @@
+#ifndef __LOADER_HPP__
+#define __LOADER_HPP__
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <iterator>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+    text of a program file, mapped read only so that the loader tokenizes it in place and the parsed commands
+    keep viewing it; a file that cannot be mapped (a pipe, an empty file) is read into memory instead
+*/
+struct SourceFile{
+    std::shared_ptr<const void> mapping;  // unmapped once the last copy is released
+    const char *begin = nullptr, *end = nullptr;
+
+    bool open(const std::string &path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) < 0)
+        {
+            if (fd >= 0)
+                close(fd);
+            return false;
+        }
+        size_t size = st.st_size;
+        void *mapped = S_ISREG(st.st_mode) && size ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        close(fd);
+        if (mapped == MAP_FAILED)
+            return read(path);
+        madvise(mapped, size, MADV_SEQUENTIAL);
+        mapping = std::shared_ptr<const void>(mapped, [size](const void *p)
+                                              { munmap((void *)p, size); });
+        begin = (const char *)mapped;
+        end = begin + size;
+        return true;
+    }
+
+    bool read(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+            return false;
+        auto text = std::make_shared<std::string>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        begin = text->data();
+        end = begin + text->size();
+        mapping = text;
+        return true;
+    }
+};
+
+// bump allocator for the few strings the loader has to build, all released with it
+struct Arena{
+    static const size_t BLOCK = 1 << 16;
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char *block = nullptr;
+    size_t left = 0;
+
+    char *allocate(size_t size)
+    {
+        // large strings get a block of their own, leaving the current one in use
+        if (size > BLOCK / 4)
+        {
+            blocks.emplace_back(new char[size]);
+            return blocks.back().get();
+        }
+        if (size > left)
+        {
+            blocks.emplace_back(new char[BLOCK]);
+            block = blocks.back().get();
+            left = BLOCK;
+        }
+        char *bytes = block + BLOCK - left;
+        left -= size;
+        return bytes;
+    }
+};
+
+#endif
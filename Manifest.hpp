@@ -0,0 +1,140 @@
+#ifndef __MANIFEST_HPP__
+#define __MANIFEST_HPP__
+
+#include "Hazard.hpp"
+#include "Simulator.hpp"
+#include <memory>
+#include <sstream>
+#include <algorithm>
+
+/*
+    manifests of run_batch and run_bench, one job per line: <model> <file name> [simulator flags], with model one of
+    nobypass, bypass, exbypass and the flags those of the simulators (--predictor, --early-branch, --max-cycles,
+    --restore, ...); # starts a comment
+    every job is a pipelined run, a line asking for --functional or --sample is reported as bad flags
+*/
+struct ManifestJob{
+    std::string model;
+    std::vector<std::string> args;  // simulator command line: program name, file name, flags
+    std::string flags;
+    std::string status = "not run";
+    int cycles = 0;
+    long long instructions = 0, stalls = 0;
+};
+
+// append the jobs of the manifest at path, program being the name the job command lines start with
+template <class Job>
+bool readManifest(const std::string &path, const char *program, std::vector<Job> &jobs)
+{
+    std::ifstream manifest(path);
+    if (!manifest.is_open())
+        return false;
+    std::string line;
+    while (getline(manifest, line))
+    {
+        std::istringstream tokens(line.substr(0, line.find('#')));
+        Job job;
+        std::string token;
+        if (!(tokens >> job.model))
+            continue;
+        job.args.push_back(program);
+        while (tokens >> token)
+        {
+            if (job.args.size() > 1)
+                job.flags += (job.flags.empty() ? "" : " ") + token;
+            job.args.push_back(token);
+        }
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+// parse the flags of the job and call run(architecture, options), architecture being a null pointer to the pipeline of its model
+template <class Job, class Run>
+void dispatchJob(Job &job, Run &&run)
+{
+    std::vector<char *> argv;
+    for (auto &arg : job.args)
+        argv.push_back(&arg[0]);
+    SimulatorOptions options;
+    if (!parseOptions(argv.size(), argv.data(), options) || options.functional || options.sample)
+        job.status = "bad flags";
+    else if (job.model == "nobypass")
+        run((MIPS_Pipeline<NoBypass> *)nullptr, options);
+    else if (job.model == "bypass")
+        run((MIPS_Pipeline<FullBypass> *)nullptr, options);
+    else if (job.model == "exbypass")
+        run((MIPS_Pipeline<EXBypass> *)nullptr, options);
+    else
+        job.status = "bad model";
+}
+
+// load the program of the job into a pipeline configured by options, without output; null with the status set if it cannot be
+template <class Architecture>
+std::unique_ptr<Architecture> loadJob(ManifestJob &job, const SimulatorOptions &options, typename Architecture::Predictor *predictor)
+{
+    SourceFile file;
+    if (!file.open(options.fileName))
+    {
+        delete predictor;
+        job.status = "no file";
+        return nullptr;
+    }
+    std::unique_ptr<Architecture> mips(new Architecture(file));
+    mips->predictor = predictor;
+    mips->tracer.mode = OUTPUT_NONE;
+    configure(*mips, options);
+    if (!options.restorePath.empty() && mips->restoreCheckpoint(options.restorePath) != CHECKPOINT_OK)
+    {
+        job.status = "bad checkpoint";
+        return nullptr;
+    }
+    return mips;
+}
+
+// run the loaded pipeline and record its results and status, false if it threw
+template <class Architecture>
+bool executeJob(ManifestJob &job, const SimulatorOptions &options, Architecture &mips)
+{
+    try
+    {
+        mips.executeCommandsPipelined();
+    }
+    catch (std::exception &e)
+    {
+        job.status = "error";
+        return false;
+    }
+    job.cycles = mips.cycles;
+    job.instructions = mips.instructions;
+    job.stalls = mips.stalls;
+    if (mips.status != Architecture::SUCCESS)
+        job.status = "exit " + std::to_string(mips.status);
+    else if (mips.cycles >= options.cycleLimit)
+        job.status = "limit";
+    else
+        job.status = "ok";
+    return true;
+}
+
+// print the rows (the header first) as aligned columns, or as CSV
+inline void printRows(const std::vector<std::vector<std::string>> &rows, bool csv)
+{
+    size_t columns = rows[0].size();
+    std::vector<size_t> width(columns, 0);
+    for (auto &row : rows)
+        for (size_t i = 0; i < columns; ++i)
+            width[i] = std::max(width[i], row[i].size());
+    for (auto &row : rows)
+    {
+        for (size_t i = 0; i < columns; ++i)
+        {
+            if (csv)
+                std::cout << row[i] << (i < columns - 1 ? ',' : '\n');
+            else
+                std::cout << row[i] << (i < columns - 1 ? std::string(width[i] - row[i].size() + 2, ' ') : "\n");
+        }
+    }
+}
+
+#endif
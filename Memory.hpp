@@ -0,0 +1,160 @@
+#ifndef __MEMORY_HPP__
+#define __MEMORY_HPP__
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+
+/*
+    sparse word addressed data memory: 4 KB pages (1024 words) handed out zeroed from an arena on the first write
+    of a non-zero value, pages never written read as 0
+    the invalid address markers of MIPS_Pipeline::locateAddress (-3 and -4), which the pipelined models carry to
+    MEM unchecked, land in a few words below address 0 and show in the delta like any other word, as they did in
+    the inline array; other addresses outside the memory read as 0 and are never written
+    the memory delta is kept as bitmaps, one bit per word written with a different value since the last
+    clearDelta() and one bit per page holding any of them, so that reporting and clearing it only visit those
+    pages; the delta is listed in ascending address order
+*/
+struct PagedMemory{
+    static const int PAGE_BITS = 10, PAGE_WORDS = 1 << PAGE_BITS, PAGES_PER_BLOCK = 16, OUTSIDE = 4;
+
+    struct Page{
+        int words[PAGE_WORDS];
+        uint64_t delta[PAGE_WORDS / 64];
+    };
+
+    std::vector<Page *> pages;                  // page table, null until first written
+    std::vector<uint64_t> deltaPages;           // pages with a word in the delta
+    std::vector<std::unique_ptr<Page[]>> arena;
+    int freePages = 0;                          // left in the last arena block
+    int outside[OUTSIDE] = {0};                 // addresses -4 to -1
+    uint8_t outsideDelta = 0;                   // outside words in the delta
+    std::shared_ptr<void> backing;              // storage of adopted pages, see adopt()
+    size_t deltaSize = 0;
+
+    PagedMemory(int words) : pages((words + PAGE_WORDS - 1) / PAGE_WORDS, nullptr), deltaPages((pages.size() + 63) / 64, 0) {}
+
+    int read(int address) const
+    {
+        if (address < 0)
+            return address >= -OUTSIDE ? outside[address + OUTSIDE] : 0;
+        size_t index = (unsigned)address >> PAGE_BITS;
+        const Page *page = index < pages.size() ? pages[index] : nullptr;
+        return page ? page->words[address & (PAGE_WORDS - 1)] : 0;
+    }
+
+    Page *allocate(int index)
+    {
+        if (!freePages)
+        {
+            arena.emplace_back(new Page[PAGES_PER_BLOCK]());
+            freePages = PAGES_PER_BLOCK;
+        }
+        return pages[index] = &arena.back()[PAGES_PER_BLOCK - freePages--];
+    }
+
+    // take a page living outside the arena (a mapped checkpoint kept alive by backing), with its delta
+    void adopt(int index, Page *page)
+    {
+        pages[index] = page;
+        for (int w = 0; w < PAGE_WORDS / 64; ++w)
+        {
+            deltaSize += __builtin_popcountll(page->delta[w]);
+            if (page->delta[w])
+                deltaPages[index >> 6] |= 1ull << (index & 63);
+        }
+    }
+
+    // store value, adding the word to the delta if that changes it
+    void write(int address, int value)
+    {
+        if (address < 0)
+        {
+            writeOutside(address, value);
+            return;
+        }
+        int index = (unsigned)address >> PAGE_BITS, offset = address & (PAGE_WORDS - 1);
+        if ((size_t)index >= pages.size())
+            return;
+        Page *page = pages[index];
+        if (!page)
+        {
+            if (!value)
+                return;
+            page = allocate(index);
+        }
+        if (page->words[offset] == value)
+            return;
+        page->words[offset] = value;
+        uint64_t &bits = page->delta[offset >> 6], bit = 1ull << (offset & 63);
+        deltaSize += !(bits & bit);
+        bits |= bit;
+        deltaPages[index >> 6] |= 1ull << (index & 63);
+    }
+
+    void writeOutside(int address, int value)
+    {
+        if (address < -OUTSIDE || outside[address + OUTSIDE] == value)
+            return;
+        outside[address + OUTSIDE] = value;
+        deltaSize += !(outsideDelta >> (address + OUTSIDE) & 1);
+        outsideDelta |= 1 << (address + OUTSIDE);
+    }
+
+    // call visit(address, value) for every word of the delta
+    template <class Visitor>
+    void forEachDelta(Visitor &&visit) const
+    {
+        for (int i = 0; i < OUTSIDE; ++i)
+            if (outsideDelta >> i & 1)
+                visit(i - OUTSIDE, outside[i]);
+        for (size_t group = 0; group < deltaPages.size(); ++group)
+            for (uint64_t set = deltaPages[group]; set; set &= set - 1)
+            {
+                int index = group * 64 + __builtin_ctzll(set);
+                const Page *page = pages[index];
+                for (int w = 0; w < PAGE_WORDS / 64; ++w)
+                    for (uint64_t bits = page->delta[w]; bits; bits &= bits - 1)
+                    {
+                        int offset = w * 64 + __builtin_ctzll(bits);
+                        visit((index << PAGE_BITS) + offset, page->words[offset]);
+                    }
+            }
+    }
+
+    // same contents as other, word for word, pages never written counting as zeros
+    bool sameWords(const PagedMemory &other) const
+    {
+        if (!std::equal(outside, outside + OUTSIDE, other.outside) || pages.size() != other.pages.size())
+            return false;
+        for (size_t index = 0; index < pages.size(); ++index)
+            if (pages[index] || other.pages[index])
+                for (int offset = 0; offset < PAGE_WORDS; ++offset)
+                {
+                    int address = (index << PAGE_BITS) + offset;
+                    if (read(address) != other.read(address))
+                        return false;
+                }
+        return true;
+    }
+
+    void clearDelta()
+    {
+        if (!deltaSize)
+            return;
+        for (size_t group = 0; group < deltaPages.size(); ++group)
+        {
+            for (uint64_t set = deltaPages[group]; set; set &= set - 1)
+            {
+                Page *page = pages[group * 64 + __builtin_ctzll(set)];
+                std::fill(page->delta, page->delta + PAGE_WORDS / 64, 0);
+            }
+            deltaPages[group] = 0;
+        }
+        outsideDelta = 0;
+        deltaSize = 0;
+    }
+};
+
+#endif
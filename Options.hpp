@@ -0,0 +1,190 @@
+#ifndef __OPTIONS_HPP__
+#define __OPTIONS_HPP__
+
+#include <string>
+#include <iostream>
+#include <climits>
+#include "Trace.hpp"
+#include "Cache.hpp"
+
+// command line of the simulators: <file name> followed by any of the flags below
+struct SimulatorOptions{
+    std::string fileName;
+    OutputMode mode = OUTPUT_FULL;
+    std::string tracePath;
+    std::string branchTracePath;
+    std::string timelinePath;
+    std::string predictor;
+    bool earlyBranch = false;
+    bool functional = false;
+    bool sample = false;
+    long long fastForward = 0, window = 0, period = 0;
+    int cycleLimit = INT_MAX;
+    int btbSets = 0, btbWays = 0;   // no branch target buffer when 0
+    CacheConfig icache, dcache;     // no cache when size 0
+    std::string checkpointPath, restorePath;
+    int checkpointCycle = 0;
+    std::string stallReportPath;
+    int profileTop = 0;             // no profile when 0
+};
+
+static const char *const USAGE =
+    "Required argument: file_name\n"
+    "./MIPS_interpreter <file name> [--full | --delta | --final | --binary <trace file>]\n"
+    "                   [--predictor saturating | bhr | saturating-bhr | gshare[:<bits>[:<history bits>]]\n"
+    "                                | tournament[:<bits>] | tage[:<bits>]] [--early-branch]\n"
+    "                   [--functional | --sample <fast-forward> <window> <period>] [--max-cycles <cycles>]\n"
+    "                   [--branch-trace <branch trace file>] [--timeline <Konata log file>] [--btb <sets> <ways>]\n"
+    "                   [--icache <cache>] [--dcache <cache>]\n"
+    "                   [--checkpoint <checkpoint file> <cycle>] [--restore <checkpoint file>]\n"
+    "                   [--stall-report <report file, .json or .csv>] [--profile <top blocks and loops>]\n"
+    "cache: <size>:<ways>:<line>:<miss latency>[:lru | :plru][:write-back | :write-through]\n";
+
+inline bool parseOptions(int argc, char *argv[], SimulatorOptions &options)
+{
+    if (argc < 2)
+        return false;
+    options.fileName = argv[1];
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (parseOutputMode(arg, options.mode))
+        {
+            if (options.mode == OUTPUT_BINARY)
+            {
+                if (++i == argc)
+                    return false;
+                options.tracePath = argv[i];
+            }
+        }
+        else if (arg == "--predictor")
+        {
+            if (++i == argc)
+                return false;
+            options.predictor = argv[i];
+        }
+        else if (arg == "--branch-trace")
+        {
+            if (++i == argc)
+                return false;
+            options.branchTracePath = argv[i];
+        }
+        else if (arg == "--timeline")
+        {
+            if (++i == argc)
+                return false;
+            options.timelinePath = argv[i];
+        }
+        else if (arg == "--early-branch")
+            options.earlyBranch = true;
+        else if (arg == "--functional")
+            options.functional = true;
+        else if (arg == "--sample")
+        {
+            if (i + 3 >= argc)
+                return false;
+            try
+            {
+                options.fastForward = std::stoll(argv[++i]);
+                options.window = std::stoll(argv[++i]);
+                options.period = std::stoll(argv[++i]);
+            }
+            catch (std::exception &e)
+            {
+                return false;
+            }
+            if (options.fastForward < 0 || options.window <= 0 || options.period < 0)
+                return false;
+            options.sample = true;
+        }
+        else if (arg == "--max-cycles")
+        {
+            if (++i == argc)
+                return false;
+            try
+            {
+                options.cycleLimit = std::stoi(argv[i]);
+            }
+            catch (std::exception &e)
+            {
+                return false;
+            }
+            if (options.cycleLimit <= 0)
+                return false;
+        }
+        else if (arg == "--btb")
+        {
+            if (i + 2 >= argc)
+                return false;
+            try
+            {
+                options.btbSets = std::stoi(argv[++i]);
+                options.btbWays = std::stoi(argv[++i]);
+            }
+            catch (std::exception &e)
+            {
+                return false;
+            }
+            // sets a power of two
+            if (options.btbSets <= 0 || options.btbSets > (1 << 16) || (options.btbSets & (options.btbSets - 1)) ||
+                options.btbWays <= 0 || options.btbWays > 64)
+                return false;
+        }
+        else if (arg == "--checkpoint")
+        {
+            if (i + 2 >= argc)
+                return false;
+            options.checkpointPath = argv[++i];
+            try
+            {
+                options.checkpointCycle = std::stoi(argv[++i]);
+            }
+            catch (std::exception &e)
+            {
+                return false;
+            }
+            if (options.checkpointCycle <= 0)
+                return false;
+        }
+        else if (arg == "--stall-report")
+        {
+            if (++i == argc)
+                return false;
+            options.stallReportPath = argv[i];
+        }
+        else if (arg == "--profile")
+        {
+            if (++i == argc)
+                return false;
+            try
+            {
+                options.profileTop = std::stoi(argv[i]);
+            }
+            catch (std::exception &e)
+            {
+                return false;
+            }
+            if (options.profileTop <= 0)
+                return false;
+        }
+        else if (arg == "--restore")
+        {
+            if (++i == argc)
+                return false;
+            options.restorePath = argv[i];
+        }
+        else if (arg == "--icache" || arg == "--dcache")
+        {
+            if (++i == argc || !parseCacheConfig(argv[i], arg == "--icache" ? options.icache : options.dcache))
+                return false;
+        }
+        else
+            return false;
+    }
+    // checkpoints hold the state of the pipeline, and only a pipelined run has stalls and cycles to report
+    return !(options.functional || options.sample) || (options.checkpointPath.empty() && options.restorePath.empty() &&
+                                                       options.stallReportPath.empty() && !options.profileTop &&
+                                                       options.timelinePath.empty());
+}
+
+#endif
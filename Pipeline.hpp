@@ -0,0 +1,1107 @@
+/**
+ * @file Pipeline.hpp
+ * @author Mallika Prabhakar and Sayam Sethi
+ * 
+ */
+
+#ifndef __PIPELINE_HPP__
+#define __PIPELINE_HPP__
+
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <exception>
+#include <iostream>
+#include "Instruction.hpp"
+#include "Loader.hpp"
+#include "Scoreboard.hpp"
+#include "Trace.hpp"
+#include "BranchPredictor.hpp"
+#include "BranchTarget.hpp"
+#include "Cache.hpp"
+#include "Functional.hpp"
+#include "Checkpoint.hpp"
+#include "Stalls.hpp"
+#include "Profile.hpp"
+#include "Timeline.hpp"
+#include <chrono>
+#include <climits>
+#include <algorithm>
+
+
+struct ControlSignals{
+    int RegDst;
+    int ALUop1;
+    int ALUop0;
+    int ALUsrc;
+    int Branch = 0;
+    int Mem_Read;
+    int Mem_Write;
+    int Reg_Write;
+    int Mem_Reg;
+};
+
+
+struct IF_ID{
+    int PC;
+};
+
+
+struct ID_EX{
+    int PC;
+    int ReadData1;
+    int ReadData2;
+    Opcode opcode;
+    int adder;
+    int rd;
+    ControlSignals controls;
+};
+
+struct EX_MEM{
+    ControlSignals controls;
+    int PC;
+    int zero = 0;
+    int ALUresult;
+    int ReadData2;
+    int rd;
+};
+
+struct MEM_WB{
+    ControlSignals controls;
+    int ReadData;
+    int ALUresult;
+    int rd;
+};
+
+enum Stage{
+    STAGE_IF = 0,
+    STAGE_ID,
+    STAGE_EX,
+    STAGE_MEM,
+    STAGE_WB,
+    NUM_STAGES
+};
+
+// outcome of one clock cycle: nothing left in flight, still running, or the last command has written back
+enum CycleState{
+    CYCLE_IDLE = 0,
+    CYCLE_BUSY,
+    CYCLE_LAST
+};
+
+// per-cycle pipeline state: the latches and the dynamic instruction number occupying each stage
+struct alignas(64) PipelineState{
+    int count[NUM_STAGES] = {0};
+    IF_ID if_id = {};
+    ID_EX id_ex = {};
+    EX_MEM ex_mem = {};
+    MEM_WB mem_wb = {};
+};
+
+
+
+/*
+	the five stage pipeline, specialised at compile time on a hazard policy (see Hazard.hpp) that decides how ID
+	reads its operands, when an instruction may leave ID and which results are forwarded, and on the type of its
+	branch predictor (the type erased AnyBranchPredictor unless chosen at compile time)
+*/
+template <class Hazard, class PredictorType = AnyBranchPredictor>
+struct MIPS_Pipeline
+{
+	typedef PredictorType Predictor;
+	template <class Other>
+	using WithPredictor = MIPS_Pipeline<Hazard, Other>;
+
+	int registers[32] = {0}, PCcurr = 0, PCnext,instno = 0;
+	const std::unordered_map<std::string, int> &registerMap = registerNames();
+	std::unordered_map<std::string, int> address;
+	PipelineState pipeline;
+    int dependreg[32] = {0}, branchinst = 0;
+    static const int SCOREBOARD_SIZE = 16;
+    Scoreboard<SCOREBOARD_SIZE> scoreboard;
+	static const int MAX = (1 << 20);
+	PagedMemory data{MAX >> 2};  // its delta holds the words changed since the last report
+	Tracer tracer;
+	BranchTrace branchTrace;
+	Timeline timeline;
+	Predictor *predictor = nullptr;  // owned, none when null
+	std::string predictorName;       // as given to --predictor, for checkpoints
+	BranchTargetBuffer btb;
+	Cache icache, dcache;
+	int memoryStall = 0;  // cycles the whole pipeline stays frozen for the latest cache misses
+	bool earlyBranch = false;
+	int fetchPC = 1, branches = 0, mispredicts = 0;
+	bool sampling = false;
+	long long fetched = 0, fetchLimit = LLONG_MAX;  // correct-path instructions fetched, and the cap of a detailed window
+	SourceFile source;                     // program text, viewed by commands
+	Arena arena;                           // operands joined from several tokens
+	std::vector<std::string_view> tokens;  // of the line being parsed
+	std::vector<Command> commands;
+	std::vector<Instruction> program;
+	std::vector<long long> commandCount, cycleCount;  // completed executions and cycles charged, by pc - 1
+	int profileTop = 0;  // blocks and loops listed by the profile printed after a pipelined run, none when 0
+	int cycleLimit = INT_MAX, cycles = 0;
+	std::string checkpointPath;  // written at the end of cycle checkpointCycle
+	int checkpointCycle = 0;
+	long long instructions = 0, stalls = 0;  // instructions completed, and cycles the instruction in ID was held by a hazard
+	StallStats stallStats;
+	std::string stallReportPath;  // written at the end of a pipelined run
+	enum exit_code
+	{
+		SUCCESS = 0,
+		INVALID_REGISTER,
+		INVALID_LABEL,
+		INVALID_ADDRESS,
+		SYNTAX_ERROR,
+		MEMORY_ERROR
+	};
+	exit_code status = SUCCESS;
+
+	// constructor to load the program, the register names are shared by every instance
+	MIPS_Pipeline(const SourceFile &file) : source(file)
+	{
+		constructCommands();
+		commandCount.assign(commands.size(), 0);
+		cycleCount.assign(commands.size(), 0);
+		stallStats.resize(commands.size());
+	}
+
+	~MIPS_Pipeline()
+	{
+		delete predictor;
+	}
+
+	// resolve the word address of a decoded lw/sw operand, base being the value of its base register as read in ID
+	int locateAddress(const Instruction &inst, int base)
+	{
+		int address;
+		if ((inst.flags & MEM_PAREN)&&(!(inst.flags & RS_VALID)))
+			return -3;
+		else if (inst.flags & MEM_PAREN)
+			address = base + inst.imm;
+		else if (inst.flags & MEM_ABS_BAD)
+			return -4;
+		else
+			address = inst.imm;
+		if (address % 4 || address < int(4 * commands.size()) || address >= MAX)
+			return -3;
+		return address / 4;
+	}
+
+
+	// checks if label is valid
+	inline bool checkLabel(std::string str)
+	{
+		return str.size() > 0 && isalpha(str[0]) && all_of(++str.begin(), str.end(), [](char c)
+														   { return (bool)isalnum(c); }) &&
+			   lookupOpcode(str) == OP_INVALID;
+	}
+
+	// checks if the register is a valid one
+	inline bool checkRegister(std::string r)
+	{
+		return registerMap.find(r) != registerMap.end();
+	}
+
+	// checks if all of the registers are valid or not
+	bool checkRegisters(std::vector<std::string> regs)
+	{
+		return std::all_of(regs.begin(), regs.end(), [&](std::string r)
+						   { return checkRegister(r); });
+	}
+
+	/*
+		handle all exit codes:
+		0: correct execution
+		1: register provided is incorrect
+		2: invalid label
+		3: unaligned or invalid address
+		4: syntax error
+		5: commands exceed memory limit
+	*/
+	void handleExit(exit_code code, int, bool cut = false)
+	{
+		status = code;
+		if (tracer.mode == OUTPUT_NONE)
+			return;
+		// a run cut at its checkpoint leaves the output open for the resumed run
+		if (!cut)
+			std::cout << '\n';
+		switch (code)
+		{
+		case 1:
+			std::cerr << "Invalid register provided or syntax error in providing register\n";
+			break;
+		case 2:
+			std::cerr << "Label used not defined or defined too many times\n";
+			break;
+		case 3:
+			std::cerr << "Unaligned or invalid memory address specified\n";
+			break;
+		case 4:
+			std::cerr << "Syntax error encountered\n";
+			break;
+		case 5:
+			std::cerr << "Memory limit exceeded\n";
+			break;
+		default:
+			break;
+		}
+		if (code != 0)
+		{
+			std::cerr << "Error encountered at:\n";
+			for (auto &s : commands[PCcurr])
+				std::cerr << s << ' ';
+			std::cerr << '\n';
+		}
+	}
+
+	// define label at the next command, or mark it as defined too many times
+	void defineLabel(std::string_view label)
+	{
+		auto entry = address.emplace(std::string(label), (int)commands.size());
+		if (!entry.second)
+			entry.first->second = -1;
+	}
+
+	// the operands from tokens[first] on, joined by spaces into the arena
+	std::string_view joinTokens(size_t first)
+	{
+		size_t size = tokens.size() - first - 1;
+		for (size_t i = first; i < tokens.size(); ++i)
+			size += tokens[i].size();
+		char *joined = arena.allocate(size), *out = joined;
+		for (size_t i = first; i < tokens.size(); ++i)
+		{
+			if (i > first)
+				*out++ = ' ';
+			out = std::copy(tokens[i].begin(), tokens[i].end(), out);
+		}
+		return std::string_view(joined, size);
+	}
+
+	// parse the command assuming correctly formatted MIPS instruction (or label), and decode it
+	void parseCommand(std::string_view line)
+	{
+		// strip until before the comment begins
+		line = line.substr(0, line.find('#'));
+		tokens.clear();
+		for (size_t i = 0, next; i < line.size(); i = next + 1)
+		{
+			for (next = i; next < line.size() && line[next] != ',' && line[next] != ' ' && line[next] != '\t'; ++next)
+				;
+			if (next > i)
+				tokens.push_back(line.substr(i, next - i));
+		}
+		size_t first = 0, idx;
+		// empty line or a comment only line
+		if (tokens.empty())
+			return;
+		else if (tokens.size() == 1)
+		{
+			defineLabel(tokens[0].back() == ':' ? tokens[0].substr(0, tokens[0].size() - 1) : "?");
+			return;
+		}
+		else if (tokens[0].back() == ':')
+		{
+			defineLabel(tokens[0].substr(0, tokens[0].size() - 1));
+			first = 1;
+		}
+		else if ((idx = tokens[0].find(':')) != std::string_view::npos)
+		{
+			defineLabel(tokens[0].substr(0, idx));
+			tokens[0] = tokens[0].substr(idx + 1);
+		}
+		else if (tokens[1][0] == ':')
+		{
+			defineLabel(tokens[0]);
+			tokens[1] = tokens[1].substr(1);
+			first = tokens[1].empty() ? 2 : 1;
+		}
+		if (first == tokens.size())
+			return;
+		Command command;
+		for (size_t i = 0; i < 4 && first + i < tokens.size(); ++i)
+			command[i] = tokens[first + i];
+		if (tokens.size() - first > 4)
+			command[3] = joinTokens(first + 3);
+		commands.push_back(command);
+		program.push_back(decodeCommand(command, registerMap));
+	}
+
+	// parse and decode the program in one pass over its text, then resolve the branch and jump targets
+	void constructCommands()
+	{
+		size_t lines = std::count(source.begin, source.end, '\n') + 1;
+		commands.reserve(lines);
+		program.reserve(lines);
+		for (const char *line = source.begin, *next; line < source.end; line = next + 1)
+		{
+			next = std::find(line, source.end, '\n');
+			parseCommand(std::string_view(line, next - line));
+		}
+		for (size_t i = 0; i < program.size(); ++i)
+			resolveTarget(program[i], commands[i], address);
+	}
+
+    // controlNumbers = {{"add", 0}, {"sub", 0}, {"mul", 0}, {"beq", 3}, {"bne", 3}, {"slt", 0}, {"j", 4}, {"lw", 1}, {"sw", 2}, {"addi", 0}};
+
+    void assignControls(const Instruction &inst,ControlSignals &signals){
+        int type = inst.control;
+        switch(type){
+            case 0:
+                signals.RegDst = 1;
+                signals.ALUop1 = 1;
+                signals.ALUop0 = 0;
+                signals.ALUsrc = 0;
+                signals.Branch = 0;
+                signals.Mem_Read = 0;
+                signals.Mem_Write = 0;
+                signals.Reg_Write = 1;
+                signals.Mem_Reg = 0;
+                break;
+            case 1:
+                signals.RegDst = 0;
+                signals.ALUop1 = 0;
+                signals.ALUop0 = 0;
+                signals.ALUsrc = 1;
+                signals.Branch = 0;
+                signals.Mem_Read = 1;
+                signals.Mem_Write = 0;
+                signals.Reg_Write = 1;
+                signals.Mem_Reg = 1;
+                break;
+            case 2:
+                signals.RegDst = 0;
+                signals.ALUop1 = 0;
+                signals.ALUop0 = 0;
+                signals.ALUsrc = 1;
+                signals.Branch = 0;
+                signals.Mem_Read = 0;
+                signals.Mem_Write = 1;
+                signals.Reg_Write = 0;
+                signals.Mem_Reg = 0;
+                break;
+            case 3:
+                signals.RegDst = 0;
+                signals.ALUop1 = 0;
+                signals.ALUop0 = 1;
+                signals.ALUsrc = 0;
+                signals.Branch = 1;
+                signals.Mem_Read = 0;
+                signals.Mem_Write = 0;
+                signals.Reg_Write = 0;
+                signals.Mem_Reg = 0;
+                break;
+            case 4:
+                signals.RegDst = 0;
+                signals.ALUop1 = 0;
+                signals.ALUop0 = 0;
+                signals.ALUsrc = 0;
+                signals.Branch = 1;
+                signals.Mem_Read = 0;
+                signals.Mem_Write = 0;
+                signals.Reg_Write = 0;
+                signals.Mem_Reg = 0;
+                break;
+            default:
+                break;
+        }
+    }
+
+    // IF stage driven by fetchPC: follows the predicted path under speculative fetch, and the path
+    // resolved in ID under early branch resolution
+    void fetchNext(IF_ID &if_id){
+        PCnext = fetchPC;
+        instno = instno + 1;
+        pipeline.count[STAGE_IF] = instno;
+        auto &entry = scoreboard.allocate(instno, PCnext, Hazard::PENDING);
+        if (PCnext <= (int)commands.size()){
+            timeline.stage(instno, PCnext, TIMELINE_IF);
+            fetchLine(PCnext);
+            if_id.PC = instno;
+            pipeline.count[STAGE_ID] = if_id.PC;
+            fetched = fetched + 1;
+            fetchPC = predictNext(PCnext);
+            entry.predicted = fetchPC;
+        }
+    }
+
+    // the instruction at pc (1-based) goes through the I-cache, instructions sitting at the bottom of memory
+    void fetchLine(int pc){
+        if (icache.enabled()){
+            int stall = icache.access(4 * (pc - 1), false);
+            memoryStall = memoryStall + stall;
+            stallStats.freeze(pc, stall);
+        }
+    }
+
+    // next PC after the instruction at pc (1-based), jumps are always taken and branches not taken without a predictor
+    int predictNext(int pc){
+        const Instruction &inst = program[pc - 1];
+        if (btb.enabled()){
+            return predictTarget(pc, inst);
+        }
+        if ((inst.type == 4)||((inst.type == 1)&&(predictor)&&(predictor->predict(pc - 1)))){
+            return inst.target + 1;
+        }
+        return pc + 1;
+    }
+
+    // fetch redirected by the branch target buffer: a hit is taken if unconditional or predicted taken
+    int predictTarget(int pc, const Instruction &inst){
+        int target;
+        bool conditional;
+        bool control = (inst.type == 1)||(inst.type == 4);
+        btb.lookups = btb.lookups + control;
+        if (!btb.lookup(pc - 1, target, conditional)){
+            return pc + 1;
+        }
+        btb.hits = btb.hits + control;
+        if ((!conditional)||((predictor)&&(predictor->predict(pc - 1)))){
+            return target + 1;
+        }
+        return pc + 1;
+    }
+
+    // resolve branch id and squash the path fetched after it if that was the wrong one
+    void resolveBranch(int id,bool taken,int target){
+        int pc = scoreboard[id].instmap;
+        int actual = taken ? target + 1 : pc + 1;
+        if (program[pc - 1].type == 1){
+            branches = branches + 1;
+            branchTrace.record(pc - 1, taken);
+            if (predictor){
+                predictor->update(pc - 1, taken);
+            }
+        }
+        if ((taken)&&(btb.enabled())){
+            btb.insert(pc - 1, target, program[pc - 1].type == 1);
+        }
+        if (actual != scoreboard[id].predicted){
+            // jumps only redirect late on a branch target buffer miss, which the hit rate already reports
+            if ((predictor)&&(program[pc - 1].type == 1)){
+                mispredicts = mispredicts + 1;
+            }
+            squash(id);
+            fetchPC = actual;
+        }
+    }
+
+    // early branch resolution: compare the operands read in ID and redirect fetch before EX
+    void resolveEarly(ID_EX &id_ex){
+        int id = pipeline.count[STAGE_ID];
+        scoreboard[id].completed = 1;
+        retire(id);
+        resolveBranch(id, ALU::execute(id_ex.opcode, id_ex.ReadData1, id_ex.ReadData2) == 0, id_ex.adder);
+    }
+
+    // drop every instruction fetched after id, none of them has gone past EX yet
+    void squash(int id){
+        for (int i = id + 1; i <= instno; ++i){
+            scoreboard[i].completed = 1;
+            if (scoreboard[i].instmap <= (int)commands.size()){
+                fetched = fetched - 1;
+                stallStats.bubble(scoreboard[id].instmap);
+                timeline.leave(i, true);
+            }
+        }
+        for (int i = 0; i < 32; ++i){
+            if (dependreg[i] > id){
+                dependreg[i] = 0;
+            }
+        }
+        for (int stage = STAGE_IF; stage <= STAGE_EX; ++stage){
+            if ((pipeline.count[stage] > id)||(pipeline.count[stage] == -1)){
+                pipeline.count[stage] = id;
+            }
+        }
+    }
+
+    //IF stage
+    void IF(IF_ID &if_id,EX_MEM &ex_mem){
+        if (earlyBranch){
+            // a branch waiting in ID for its operands holds fetch
+            if ((branchinst == 0)||(scoreboard[branchinst].completed)){
+                fetchNext(if_id);
+            }
+            else{
+                stallStats.bubble(scoreboard[branchinst].instmap);
+            }
+            return;
+        }
+        if ((predictor)||(sampling)||(btb.enabled())){
+            fetchNext(if_id);
+            return;
+        }
+        if ((branchinst == 0)||(scoreboard[branchinst].completed)){
+            if((ex_mem.controls.Branch == 1)&&(ex_mem.zero == 1)){
+                PCnext = ex_mem.PC + 1;
+            }
+            else{
+                PCnext = scoreboard[pipeline.count[STAGE_IF]].instmap + 1;
+            }
+            instno = instno + 1;
+            pipeline.count[STAGE_IF] = instno;
+            scoreboard.allocate(instno, PCnext, Hazard::PENDING);
+            if (PCnext <= (int)commands.size()){
+                timeline.stage(instno, PCnext, TIMELINE_IF);
+                fetchLine(PCnext);
+                if_id.PC = instno;
+                if (scoreboard[if_id.PC].instmap <= (int)commands.size()){
+                    pipeline.count[STAGE_ID] = if_id.PC;
+                }
+            }
+        }
+        else{
+            stallStats.bubble(scoreboard[branchinst].instmap);
+        }
+    }
+
+    //ID stage
+    void ID(IF_ID &if_id,ID_EX &id_ex){
+        timeline.stage(pipeline.count[STAGE_ID], scoreboard[pipeline.count[STAGE_ID]].instmap, TIMELINE_ID);
+        id_ex.PC = if_id.PC;
+        assignControls(program[scoreboard[pipeline.count[STAGE_ID]].instmap-1],id_ex.controls);
+        Hazard::decode(*this,program[scoreboard[pipeline.count[STAGE_ID]].instmap-1],id_ex);
+        if (Hazard::ready(*this)){
+            stallStats.release(scoreboard[pipeline.count[STAGE_ID]].instmap);
+            pipeline.count[STAGE_EX] = pipeline.count[STAGE_ID];
+        }
+        else{
+            Hazard::stall(*this);
+            hold();
+        }
+    }
+
+    // the instruction in ID is held another cycle by a data hazard, charged to it and to the type of its producer
+    void hold(){
+        stalls = stalls + 1;
+        int pc = scoreboard[pipeline.count[STAGE_ID]].instmap;
+        if ((pc >= 1)&&(pc <= (int)program.size())){
+            int producer = scoreboard[Hazard::blocker(*this, program[pc - 1])].instmap;
+            stallStats.hold(pc, ((producer >= 1)&&(producer <= (int)program.size())) ? program[producer - 1].type : 0);
+        }
+    }
+
+    // the instruction in ID read the result of producer before its write back: from EX this cycle, or from MEM
+    void forwarded(int producer){
+        if (scoreboard[producer].completed){
+            return;
+        }
+        int pc = scoreboard[pipeline.count[STAGE_ID]].instmap;
+        if (producer == pipeline.count[STAGE_WB]){
+            stallStats.forward(pc, 1);
+        }
+        else if (producer == pipeline.count[STAGE_MEM]){
+            stallStats.forward(pc, 0);
+        }
+    }
+
+    //EX stage
+    void EX(ID_EX &id_ex, EX_MEM &ex_mem){
+        timeline.stage(pipeline.count[STAGE_EX], scoreboard[pipeline.count[STAGE_EX]].instmap, TIMELINE_EX);
+        ex_mem.PC = id_ex.adder;
+        int alu2;
+        if (id_ex.controls.ALUsrc == 1){
+            alu2 = id_ex.adder;
+        }
+        else{
+            alu2 = id_ex.ReadData2;
+        }
+        int ret = (int) ALU::execute(id_ex.opcode,id_ex.ReadData1,alu2);
+        if (opcodeTypes[id_ex.opcode] != 2){
+            Hazard::executed(*this,pipeline.count[STAGE_EX],ret);
+        }
+        if (ret == 0){
+            ex_mem.zero = 1;
+        }
+        else{
+            ex_mem.zero = 0;
+        }
+        ex_mem.ALUresult = ret;
+        ex_mem.rd = id_ex.rd;
+        ex_mem.ReadData2 = id_ex.ReadData2;
+        ex_mem.controls = id_ex.controls;
+        pipeline.count[STAGE_MEM] = pipeline.count[STAGE_EX];
+    }
+
+    //MEM stage
+    void MEM(EX_MEM &ex_mem,MEM_WB &mem_wb,IF_ID){
+        timeline.stage(pipeline.count[STAGE_MEM], scoreboard[pipeline.count[STAGE_MEM]].instmap, TIMELINE_MEM);
+        if ((ex_mem.controls.Branch == 1)&&(ex_mem.controls.Mem_Read == 0)){
+            scoreboard[pipeline.count[STAGE_MEM]].completed = 1;
+            retire(pipeline.count[STAGE_MEM]);
+            if ((predictor)||(sampling)||(btb.enabled())){
+                resolveBranch(pipeline.count[STAGE_MEM], ex_mem.zero == 1, ex_mem.PC);
+            }
+        }
+        if ((dcache.enabled())&&((ex_mem.controls.Mem_Write == 1)||(ex_mem.controls.Mem_Read == 1))){
+            int stall = dcache.access(4 * ex_mem.ALUresult, ex_mem.controls.Mem_Write == 1);
+            memoryStall = memoryStall + stall;
+            stallStats.freeze(scoreboard[pipeline.count[STAGE_MEM]].instmap, stall);
+        }
+        if(ex_mem.controls.Mem_Write == 1){
+            data.write(ex_mem.ALUresult, ex_mem.ReadData2);
+            Hazard::accessed(*this,pipeline.count[STAGE_MEM],ex_mem.ReadData2);
+            scoreboard[pipeline.count[STAGE_MEM]].completed = 1;
+            retire(pipeline.count[STAGE_MEM]);
+        }
+        if (ex_mem.controls.Mem_Read == 1){
+            mem_wb.ReadData = data.read(ex_mem.ALUresult);
+            Hazard::accessed(*this,pipeline.count[STAGE_MEM],mem_wb.ReadData);
+        }
+        else{
+            mem_wb.ReadData = 0;
+        }
+        if ((Hazard::ALL_TO_WB)||(!scoreboard[pipeline.count[STAGE_MEM]].completed)){
+            mem_wb.rd = ex_mem.rd;
+            mem_wb.controls = ex_mem.controls;
+            mem_wb.ALUresult = ex_mem.ALUresult;
+            pipeline.count[STAGE_WB] = pipeline.count[STAGE_MEM];
+        }
+    }
+
+    //Write Back
+    void WB(MEM_WB &mem_wb){
+        timeline.stage(pipeline.count[STAGE_WB], scoreboard[pipeline.count[STAGE_WB]].instmap, TIMELINE_WB);
+        int write;
+        if(mem_wb.controls.Mem_Reg == 1){
+            write = mem_wb.ReadData;
+        }
+        else{
+            write = mem_wb.ALUresult;
+        }
+        if (mem_wb.controls.Reg_Write == 1){
+            registers[mem_wb.rd] = write;
+            scoreboard[pipeline.count[STAGE_WB]].completed = 1;
+            retire(pipeline.count[STAGE_WB]);
+        }
+    }
+
+    void retire(int id){
+        instructions = instructions + 1;
+        commandCount[scoreboard[id].instmap - 1] += 1;
+        timeline.leave(id, false);
+    }
+
+    // charge the cycle to the oldest instruction in flight
+    void charge(){
+        for (int stage = STAGE_WB; stage >= STAGE_IF; --stage){
+            int id = pipeline.count[stage];
+            if ((id > 0)&&(!scoreboard[id].completed)&&(scoreboard[id].instmap <= (int)commands.size())){
+                cycleCount[scoreboard[id].instmap - 1] += 1;
+                return;
+            }
+        }
+    }
+
+    // advance the pipeline by one clock cycle, running the stages back to front
+    int cycle(){
+        IF_ID &if_id = pipeline.if_id;
+        ID_EX &id_ex = pipeline.id_ex;
+        EX_MEM &ex_mem = pipeline.ex_mem;
+        MEM_WB &mem_wb = pipeline.mem_wb;
+        charge();
+        // a cache miss freezes every stage for its latency
+        if (memoryStall > 0){
+            memoryStall = memoryStall - 1;
+            return CYCLE_BUSY;
+        }
+        int end = 0;
+        if (!scoreboard[pipeline.count[STAGE_WB]].completed){
+            end = 1;
+            if (pipeline.count[STAGE_WB] != 0){
+                WB(mem_wb);
+                if (scoreboard[pipeline.count[STAGE_WB]].instmap == (int)commands.size()){
+                    return CYCLE_LAST;
+                }
+            }
+        }
+        if (!scoreboard[pipeline.count[STAGE_MEM]].completed){
+            end = 1;
+            if (pipeline.count[STAGE_MEM] != 0){
+                MEM(ex_mem,mem_wb,if_id);
+            }
+        }
+        if (Hazard::canExecute(*this)){
+            if (!scoreboard[pipeline.count[STAGE_EX]].completed){
+                end = 1;
+                if (pipeline.count[STAGE_EX] != 0){
+                    EX(id_ex,ex_mem);
+                }
+            }
+        }
+        if (Hazard::canDecode(*this)){
+            if (!scoreboard[pipeline.count[STAGE_ID]].completed){
+                end = 1;
+                if (pipeline.count[STAGE_ID] != 0){
+                    ID(if_id,id_ex);
+                }
+            }
+            if ((scoreboard[pipeline.count[STAGE_IF]].dependinst == 0)||(scoreboard[scoreboard[pipeline.count[STAGE_IF]].dependinst].completed)){
+                if ((scoreboard[pipeline.count[STAGE_IF]].instmap <= (int)commands.size())&&(fetched < fetchLimit)){
+                    end = 1;
+                    IF(if_id,ex_mem);
+                }
+            }
+        }
+        else{
+            hold();
+            timeline.stage(pipeline.count[STAGE_ID], scoreboard[pipeline.count[STAGE_ID]].instmap, TIMELINE_STALL);
+        }
+        return end ? CYCLE_BUSY : CYCLE_IDLE;
+    }
+
+	// stream the timeline of the pipelined run into path, see Timeline.hpp
+	bool openTimeline(const std::string &path)
+	{
+		std::vector<std::string> texts;
+		for (auto &command : commands)
+			texts.push_back(StallStats::text(command));
+		return timeline.open(path, texts);
+	}
+
+	// execute the commands in the pipeline
+	void executeCommandsPipelined()
+	{
+		if (commands.size() >= MAX / 4)
+		{
+			handleExit(MEMORY_ERROR, 0);
+			return;
+		}
+
+		// a restored run picks up after the cycle its checkpoint was taken at
+		int clockCycles = cycles;
+		bool checkpointed = false, cut = false;
+		if (clockCycles == 0)
+			printRegistersAndMemoryDelta(clockCycles);
+		while (clockCycles < cycleLimit)
+		{
+			++clockCycles;
+            timeline.advance(clockCycles);
+            int state = cycle();
+            if (state == CYCLE_LAST){
+                printRegistersAndMemoryDelta(clockCycles, true);
+                break;
+            }
+            if (state == CYCLE_IDLE){
+                break;
+            }
+            printRegistersAndMemoryDelta(clockCycles);
+            if (clockCycles == checkpointCycle){
+                cycles = clockCycles;
+                checkpointed = saveCheckpoint(checkpointPath);
+                if (!checkpointed){
+                    std::cerr << "Checkpoint could not be written\n";
+                }
+                // the run is cut at the checkpoint when it is also the last cycle allowed
+                else if (clockCycles == cycleLimit){
+                    cut = true;
+                    break;
+                }
+            }
+		}
+		if ((checkpointCycle)&&(clockCycles < checkpointCycle)){
+			std::cerr << "Checkpoint not written, the run ended at cycle " << clockCycles << " before cycle " << checkpointCycle << '\n';
+		}
+		cycles = clockCycles;
+		// one more cycle so that the stages of the last one show
+		timeline.advance(clockCycles + 1);
+		timeline.close();
+		finishTrace();
+		// in --final the cut run prints the state at the cut as a whole output of its own
+		handleExit(SUCCESS, clockCycles, (cut)&&(tracer.mode != OUTPUT_FINAL));
+		if ((predictor)||(earlyBranch)||(btb.enabled()))
+			printBranchStats(clockCycles);
+		printCacheStats();
+		if ((!stallReportPath.empty())&&(!stallStats.write(stallReportPath, Hazard::NAME, clockCycles, instructions, commands)))
+			std::cerr << "Stall report could not be written\n";
+		if ((profileTop)&&(tracer.mode != OUTPUT_NONE))
+			Profile{program, commands, address, commandCount, cycleCount, stallStats}.print(std::cerr, clockCycles, profileTop);
+	}
+
+	// execute the commands back to back without modelling the pipeline and print the final state
+	void executeCommandsFunctional()
+	{
+		if (commands.size() >= MAX / 4)
+		{
+			handleExit(MEMORY_ERROR, 0);
+			return;
+		}
+		auto start = std::chrono::steady_clock::now();
+		FunctionalResult result = executeFunctional(*this, PCcurr);
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		printState();
+		data.clearDelta();
+		handleExit((exit_code)result.exitCode, 0);
+		std::cerr << "Instructions: " << result.instructions << '\n';
+		if (elapsed.count() > 0)
+			std::cerr << "MIPS: " << result.instructions / elapsed.count() / 1e6 << '\n';
+	}
+
+	// run the pipeline from pc (0-based) with empty latches until window instructions of the correct path have
+	// been fetched and drained, leaving pc at the next instruction to execute; returns the cycles taken
+	int runWindow(int &pc, long long window, long long &retired)
+	{
+		pipeline = PipelineState();
+		scoreboard = Scoreboard<SCOREBOARD_SIZE>();
+		scoreboard.entries[0].completed = 1;  // the empty stages must not hold the drain up
+		std::fill(dependreg, dependreg + 32, 0);
+		instno = 0;
+		branchinst = 0;
+		fetchPC = pc + 1;
+		fetched = 0;
+		fetchLimit = window;
+		int clockCycles = 0, state;
+		do
+		{
+			++clockCycles;
+			state = cycle();
+		} while (state == CYCLE_BUSY);
+		retired = fetched;
+		pc = state == CYCLE_LAST ? program.size() : fetchPC - 1;
+		fetchLimit = LLONG_MAX;
+		return clockCycles;
+	}
+
+	/*
+		sampled simulation: fast-forward functionally, then alternate detailed windows of the pipeline with
+		functional stretches so that a window starts every period instructions (one window if period is 0)
+		the CPI measured over the windows is extrapolated to the whole run, the final state is printed as in --final
+		fetch follows fetchPC in the windows (not-taken without a predictor) so that the pipeline resumes exactly
+		where the functional core left off
+	*/
+	void executeCommandsSampled(long long fastForward, long long window, long long period)
+	{
+		if (commands.size() >= MAX / 4)
+		{
+			handleExit(MEMORY_ERROR, 0);
+			return;
+		}
+		sampling = true;
+		int pc = 0, exitCode = SUCCESS, windows = 0;
+		long long instructions = 0, detailed = 0, detailedCycles = 0, skip = fastForward;
+		while (pc < (int)program.size())
+		{
+			FunctionalResult result = executeFunctional(*this, pc, skip);
+			instructions += result.instructions;
+			if (result.exitCode != SUCCESS)
+			{
+				exitCode = result.exitCode;
+				break;
+			}
+			if (pc >= (int)program.size())
+				break;
+			long long retired;
+			detailedCycles += runWindow(pc, window, retired);
+			detailed += retired;
+			instructions += retired;
+			windows = windows + 1;
+			skip = period ? std::max(period - window, 0LL) : -1;
+		}
+		PCcurr = pc;
+		printState();
+		data.clearDelta();
+		handleExit((exit_code)exitCode, 0);
+		std::cerr << "Instructions: " << instructions << "\nWindows: " << windows << "\nDetailed instructions: " << detailed
+				  << "\nDetailed cycles: " << detailedCycles << '\n';
+		if (detailed)
+		{
+			double cpi = (double)detailedCycles / detailed;
+			std::cerr << "CPI: " << cpi << "\nEstimated cycles: " << (long long)(cpi * instructions + 0.5) << '\n';
+		}
+	}
+
+	// everything a pipelined run needs to resume besides the program, the memory pages and the sections below
+
+	template <class Archive>
+	void checkpointState(Archive &archive)
+	{
+		archive(registers);
+		archive(PCcurr);
+		archive(PCnext);
+		archive(instno);
+		archive(pipeline);
+		archive(dependreg);
+		archive(branchinst);
+		archive(scoreboard);
+		archive(fetchPC);
+		archive(branches);
+		archive(mispredicts);
+		archive(fetched);
+		archive(cycles);
+		archive(instructions);
+		archive(stalls);
+		archive(memoryStall);
+		archive(status);
+		archive(tracer.previous);
+		stallStats.checkpointState(archive);
+		archive(commandCount);
+		archive(cycleCount);
+	}
+
+	// FNV-1a over the program text
+	uint64_t programFingerprint() const
+	{
+		uint64_t hash = 1469598103934665603ull;
+		for (auto &command : commands)
+			for (auto &token : command)
+			{
+				for (char c : token)
+					hash = (hash ^ (unsigned char)c) * 1099511628211ull;
+				hash = (hash ^ (unsigned char)'\n') * 1099511628211ull;
+			}
+		return hash;
+	}
+
+	// how IF picks the next PC, which the pipeline state of a checkpoint depends on
+	uint32_t fetchScheme() const
+	{
+		return ((predictor) || (btb.enabled())) | earlyBranch << 1;
+	}
+
+	CheckpointHeader checkpointHeader()
+	{
+		CheckpointHeader header = {};
+		CheckpointSize size;
+		checkpointState(size);
+		std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+		std::strncpy(header.model, Hazard::NAME, sizeof(header.model) - 1);
+		header.program = programFingerprint();
+		header.fetch = fetchScheme();
+		header.stateSize = size.size;
+		return header;
+	}
+
+	bool saveCheckpoint(const std::string &path)
+	{
+		CheckpointWriter writer;
+		if (!writer.open(path))
+			return false;
+		writer(checkpointHeader());
+		checkpointState(writer);
+		checkpointSections(writer);
+		writePages(writer, data);
+		return writer.close();
+	}
+
+	// the predictor, branch target buffer and caches, restored only onto the same configuration so that one
+	// checkpoint can also seed runs with different ones (which then start cold)
+	template <class Archive>
+	void checkpointSections(Archive &archive)
+	{
+		archive.section(predictorName, [this](auto &state)
+						{ if (predictor) predictor->checkpointState(state); });
+		archive.section(btb.signature(), [this](auto &state)
+						{ btb.checkpointState(state); });
+		archive.section(icache.signature(), [this](auto &state)
+						{ icache.checkpointState(state); });
+		archive.section(dcache.signature(), [this](auto &state)
+						{ dcache.checkpointState(state); });
+	}
+
+	// resume from a checkpoint of this model, program and fetch scheme, right after construction
+	CheckpointStatus restoreCheckpoint(const std::string &path)
+	{
+		CheckpointReader reader;
+		CheckpointHeader header, expected = checkpointHeader();
+		if (!reader.open(path))
+			return CHECKPOINT_UNREADABLE;
+		reader(header);
+		if ((!reader.ok) || (std::memcmp(header.magic, expected.magic, sizeof(header.magic))) || (header.stateSize != expected.stateSize))
+			return CHECKPOINT_UNREADABLE;
+		if (std::memcmp(header.model, expected.model, sizeof(header.model)))
+			return CHECKPOINT_MODEL;
+		if (header.program != expected.program)
+			return CHECKPOINT_PROGRAM;
+		if (header.fetch != expected.fetch)
+			return CHECKPOINT_FETCH;
+		checkpointState(reader);
+		checkpointSections(reader);
+		if ((!reader.ok) || (!readPages(reader, data)))
+			return CHECKPOINT_UNREADABLE;
+		return CHECKPOINT_OK;
+	}
+
+	// print the register data and memory delta of the cycle in the selected output mode
+	void printRegistersAndMemoryDelta(int clockCycle, bool last = false)
+	{
+		switch (tracer.mode)
+		{
+		case OUTPUT_FULL:
+			printState();
+			if (!last)
+				std::cout << '\n';
+			break;
+		case OUTPUT_DELTA:
+			tracer.printDelta(clockCycle, registers, data);
+			break;
+		case OUTPUT_FINAL:
+			// keep accumulating the memory delta until the end of the run
+			return;
+		case OUTPUT_BINARY:
+			tracer.writeBinary(registers, data, last);
+			break;
+		case OUTPUT_NONE:
+			break;
+		}
+		data.clearDelta();
+	}
+
+	// print all registers followed by the memory delta
+	void printState()
+	{
+		for (int i = 0; i < 32; ++i)
+			std::cout << registers[i] << ' ';
+		std::cout << '\n';
+		std::cout << data.deltaSize << ' ';
+		data.forEachDelta([](int address, int value)
+						  { std::cout << address << ' ' << value << ' '; });
+	}
+
+	// speculative fetch and early branch summary, kept off stdout so that the trace is unaffected
+	void printBranchStats(int clockCycles)
+	{
+		if (tracer.mode == OUTPUT_NONE)
+			return;
+		std::cerr << "Cycles: " << clockCycles << "\nBranches: " << branches << '\n';
+		if (btb.enabled())
+		{
+			std::cerr << "BTB lookups: " << btb.lookups << "\nBTB hits: " << btb.hits << '\n';
+			if (btb.lookups)
+				std::cerr << "BTB hit rate: " << 100.0 * btb.hits / btb.lookups << "%\n";
+		}
+		if (!predictor)
+			return;
+		std::cerr << "Mispredicts: " << mispredicts << '\n';
+		if (branches)
+			std::cerr << "Accuracy: " << 100.0 * (branches - mispredicts) / branches << "%\n";
+	}
+
+	// hit and miss counts of the caches in use, on stderr like the branch statistics
+	void printCacheStats()
+	{
+		if (tracer.mode == OUTPUT_NONE)
+			return;
+		if (icache.enabled())
+			icache.printStats("I-cache");
+		if (dcache.enabled())
+			dcache.printStats("D-cache");
+	}
+
+	// emit whatever the output mode deferred to the end of the run
+	void finishTrace()
+	{
+		if (tracer.mode == OUTPUT_FINAL)
+		{
+			printState();
+			data.clearDelta();
+		}
+		else if (tracer.mode == OUTPUT_BINARY)
+			tracer.endBinary();
+	}
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,164 @@
+#ifndef __PROFILE_HPP__
+#define __PROFILE_HPP__
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <iostream>
+#include <cstdio>
+#include "Instruction.hpp"
+#include "Stalls.hpp"
+
+/*
+    execution profile of a pipelined run: every cycle is charged to the oldest instruction still in flight, so
+    that the cycles of the static instructions add up to the run, next to their completed executions and the
+    stall cycles of StallStats charged to them
+    the report sums these over the code following each label (up to the next one), over the basic blocks
+    (split at branch targets and after every branch or jump) and over the loops closed by a backward branch or
+    jump, and prints the top blocks and loops by cycles; pcs are 1-based as in the pipeline
+*/
+struct ProfileRange{
+    int first, last;    // pcs, inclusive
+    std::string label;
+    long long executions = 0, cycles = 0, stalls = 0;
+};
+
+struct Profile{
+    const std::vector<Instruction> &program;
+    const std::vector<Command> &commands;
+    const std::unordered_map<std::string, int> &address;
+    const std::vector<long long> &executions, &cycles;
+    const StallStats &stallStats;
+
+    long long stalls(int pc) const
+    {
+        const StallStats::Counts &c = stallStats.counts[pc - 1];
+        return c.raw + c.control + c.structural;
+    }
+
+    // executions are those of the first instruction, the times the range was entered or looped
+    ProfileRange range(int first, int last, const std::string &label) const
+    {
+        ProfileRange r = {first, last, label};
+        r.executions = executions[first - 1];
+        for (int pc = first; pc <= last; ++pc)
+        {
+            r.cycles += cycles[pc - 1];
+            r.stalls += stalls(pc);
+        }
+        return r;
+    }
+
+    // label names by pc, duplicates (address -1) and labels past the last instruction left out
+    std::vector<std::string> labels() const
+    {
+        std::vector<std::pair<std::string, int>> sorted(address.begin(), address.end());
+        std::sort(sorted.begin(), sorted.end());
+        std::vector<std::string> names(program.size() + 1);
+        for (auto &entry : sorted)
+            if (entry.second >= 0 && entry.second < (int)program.size())
+                names[entry.second + 1] += (names[entry.second + 1].empty() ? "" : ",") + entry.first;
+        return names;
+    }
+
+    std::vector<ProfileRange> labelRanges(const std::vector<std::string> &names) const
+    {
+        std::vector<ProfileRange> ranges;
+        for (int pc = 1; pc <= (int)program.size(); ++pc)
+        {
+            if (names[pc].empty())
+                continue;
+            int last = pc;
+            while (last < (int)program.size() && names[last + 1].empty())
+                ++last;
+            ranges.push_back(range(pc, last, names[pc]));
+        }
+        return ranges;
+    }
+
+    std::vector<ProfileRange> blocks(const std::vector<std::string> &names) const
+    {
+        int n = program.size();
+        std::vector<char> leader(n + 2, 0);
+        leader[1] = 1;
+        for (int pc = 1; pc <= n; ++pc)
+        {
+            const Instruction &inst = program[pc - 1];
+            if (inst.type == 1 || inst.type == 4)
+            {
+                if (inst.target >= 0 && inst.target < n)
+                    leader[inst.target + 1] = 1;
+                leader[pc + 1] = 1;
+            }
+        }
+        std::vector<ProfileRange> ranges;
+        for (int pc = 1; pc <= n;)
+        {
+            int last = pc;
+            while (last < n && !leader[last + 1])
+                ++last;
+            ranges.push_back(range(pc, last, names[pc]));
+            pc = last + 1;
+        }
+        return ranges;
+    }
+
+    std::vector<ProfileRange> loops(const std::vector<std::string> &names) const
+    {
+        std::vector<ProfileRange> ranges;
+        for (int pc = 1; pc <= (int)program.size(); ++pc)
+        {
+            const Instruction &inst = program[pc - 1];
+            if ((inst.type == 1 || inst.type == 4) && inst.target >= 0 && inst.target < pc)
+                ranges.push_back(range(inst.target + 1, pc, names[inst.target + 1]));
+        }
+        return ranges;
+    }
+
+    static void printRanges(std::ostream &out, const char *title, std::vector<ProfileRange> ranges, long long total, size_t top)
+    {
+        if (top)
+        {
+            std::stable_sort(ranges.begin(), ranges.end(), [](const ProfileRange &a, const ProfileRange &b)
+                             { return a.cycles > b.cycles; });
+            if (ranges.size() > top)
+                ranges.resize(top);
+        }
+        char line[160];
+        out << title << '\n';
+        std::snprintf(line, sizeof(line), "%-13s %-12s %12s %12s %7s %12s\n", "pcs", "label", "executions", "cycles", "%", "stalls");
+        out << line;
+        for (auto &r : ranges)
+        {
+            std::string pcs = std::to_string(r.first) + '-' + std::to_string(r.last);
+            std::snprintf(line, sizeof(line), "%-13s %-12s %12lld %12lld %6.2f%% %12lld\n", pcs.c_str(), r.label.c_str(), r.executions,
+                          r.cycles, total ? 100.0 * r.cycles / total : 0.0, r.stalls);
+            out << line;
+        }
+    }
+
+    // the whole report, the top blocks and loops by cycles; totalCycles is the length of the run
+    void print(std::ostream &out, long long totalCycles, size_t top) const
+    {
+        std::vector<std::string> names = labels();
+        long long charged = 0;
+        for (long long c : cycles)
+            charged += c;
+        char line[160];
+        out << "Profile: " << totalCycles << " cycles, " << totalCycles - charged << " with no instruction in flight\n";
+        std::snprintf(line, sizeof(line), "%-5s %12s %12s %7s %12s  %s\n", "pc", "executions", "cycles", "%", "stalls", "instruction");
+        out << line;
+        for (int pc = 1; pc <= (int)program.size(); ++pc)
+        {
+            std::snprintf(line, sizeof(line), "%-5d %12lld %12lld %6.2f%% %12lld  ", pc, executions[pc - 1], cycles[pc - 1],
+                          totalCycles ? 100.0 * cycles[pc - 1] / totalCycles : 0.0, stalls(pc));
+            out << line << (names[pc].empty() ? "" : names[pc] + ": ") << StallStats::text(commands[pc - 1]) << '\n';
+        }
+        printRanges(out, "Labels", labelRanges(names), totalCycles, 0);
+        printRanges(out, "Hot blocks", blocks(names), totalCycles, top);
+        printRanges(out, "Hot loops", loops(names), totalCycles, top);
+    }
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef __SCOREBOARD_HPP__
+#define __SCOREBOARD_HPP__
+
+/*
+    bookkeeping of the dynamic instructions in flight, indexed by instno modulo N
+    only the latest N instructions are tracked, anything older has left the pipeline and reads as completed
+*/
+template <int N>
+struct Scoreboard{
+    static_assert(N > 0 && (N & (N - 1)) == 0, "scoreboard capacity must be a power of two");
+
+    struct Entry{
+        int completed;
+        int dependinst;
+        int instmap;
+        int extract;
+        int predicted;  // next PC fetched after this instruction under speculative fetch
+    };
+
+    Entry entries[N] = {};
+    Entry retired = {};
+    int head = 0;
+
+    // whether instno still owns its slot
+    inline bool tracks(int instno) const
+    {
+        return (unsigned)(head - instno) < (unsigned)N;
+    }
+
+    inline Entry &operator[](int instno)
+    {
+        if (tracks(instno))
+            return entries[instno & (N - 1)];
+        retired = {1, 0, 0, 0, 0};
+        return retired;
+    }
+
+    // claim the slot of a newly fetched instruction
+    inline Entry &allocate(int instno, int pc, int extract = 0)
+    {
+        head = instno;
+        Entry &entry = entries[instno & (N - 1)];
+        entry = {0, 0, pc, extract, 0};
+        return entry;
+    }
+};
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef __SIMULATOR_HPP__
+#define __SIMULATOR_HPP__
+
+#include <type_traits>
+#include <memory>
+#include "Options.hpp"
+
+// apply the options that configure the pipeline itself, the branch predictor being installed by the caller
+template <class Architecture>
+void configure(Architecture &mips, const SimulatorOptions &options)
+{
+	mips.earlyBranch = options.earlyBranch;
+	mips.cycleLimit = options.cycleLimit;
+	if (options.btbSets)
+		mips.btb.resize(options.btbSets, options.btbWays);
+	if (options.icache.size)
+		mips.icache.configure(options.icache);
+	if (options.dcache.size)
+		mips.dcache.configure(options.dcache);
+	mips.predictorName = options.predictor;
+	mips.checkpointPath = options.checkpointPath;
+	mips.checkpointCycle = options.checkpointCycle;
+	mips.stallReportPath = options.stallReportPath;
+	mips.profileTop = options.profileTop;
+}
+
+// run one simulation with the given predictor (null for none), which the pipeline takes ownership of
+template <class Architecture>
+int run(const SimulatorOptions &options, typename Architecture::Predictor *predictor)
+{
+	SourceFile file;
+	std::unique_ptr<Architecture> mips;
+	if (file.open(options.fileName))
+		mips.reset(new Architecture(file));
+	else
+	{
+		delete predictor;
+		std::cerr << "File could not be opened. Terminating...\n";
+		return 0;
+	}
+	mips->predictor = predictor;
+	mips->tracer.mode = options.mode;
+	if (options.mode == OUTPUT_BINARY && !mips->tracer.writer.open(options.tracePath))
+	{
+		std::cerr << "Trace file could not be opened. Terminating...\n";
+		return 0;
+	}
+	if (!options.branchTracePath.empty() && !mips->branchTrace.open(options.branchTracePath))
+	{
+		std::cerr << "Branch trace file could not be opened. Terminating...\n";
+		return 0;
+	}
+	if (!options.timelinePath.empty() && !mips->openTimeline(options.timelinePath))
+	{
+		std::cerr << "Timeline file could not be opened. Terminating...\n";
+		return 0;
+	}
+	if (!options.predictor.empty() && !predictor)
+	{
+		std::cerr << "Unknown branch predictor " << options.predictor << '\n';
+		return 0;
+	}
+	configure(*mips, options);
+	CheckpointStatus restored = options.restorePath.empty() ? CHECKPOINT_OK : mips->restoreCheckpoint(options.restorePath);
+	if (restored != CHECKPOINT_OK)
+	{
+		std::cerr << checkpointError(restored) << ". Terminating...\n";
+		return 0;
+	}
+
+	if (options.functional)
+		mips->executeCommandsFunctional();
+	else if (options.sample)
+		mips->executeCommandsSampled(options.fastForward, options.window, options.period);
+	else
+		mips->executeCommandsPipelined();
+	return 0;
+}
+
+/*
+	command line driver shared by the simulators, Architecture being one specialisation of MIPS_Pipeline
+	the pipeline is instantiated for the predictor named on the command line so that its calls are static
+*/
+template <class Architecture>
+int simulate(int argc, char *argv[])
+{
+	SimulatorOptions options;
+	if (!parseOptions(argc, argv, options))
+	{
+		std::cerr << USAGE;
+		return 0;
+	}
+	std::ios::sync_with_stdio(false);
+	int result = 0;
+	auto visit = [&](auto *predictor)
+	{
+		typedef typename std::remove_pointer<decltype(predictor)>::type Predictor;
+		result = run<typename Architecture::template WithPredictor<Predictor>>(options, predictor);
+	};
+	if (options.predictor.empty() || !withPredictor(options.predictor, visit))
+		result = run<Architecture>(options, nullptr);
+	return result;
+}
+
+#endif
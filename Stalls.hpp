@@ -0,0 +1,175 @@
+#ifndef __STALLS_HPP__
+#define __STALLS_HPP__
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <cstdint>
+#include "Instruction.hpp"
+
+/*
+    hazard accounting of a pipelined run, every cycle lost charged to one static instruction (pc 1-based):
+    raw         cycles the instruction was held in ID by a data hazard, split by the type of the producer it
+                waited on (alu for R-type, load for lw, immediate for addi), load the load-use stalls
+    control     bubbles behind a branch or jump: cycles IF waited for it to resolve, and wrong path
+                instructions squashed when it did
+    structural  cycles the whole pipeline was frozen by the cache misses of the instruction
+    forwards    operands the instruction read from a producer that had not written back, the result of EX in
+                the same cycle (ex, the EX->EX path) or of MEM (mem, the MEM->EX path)
+    held        histogram of the dynamic instances held in ID for 1, 2, 3, 4 and 5 or more cycles
+*/
+struct StallStats{
+    static constexpr int PRODUCERS = 3, BUCKETS = 5;
+
+    struct Counts{
+        long long raw = 0, loadUse = 0, control = 0, structural = 0;
+        long long forwards[2] = {0, 0};
+        long long held[BUCKETS] = {0};
+    };
+
+    long long raw[PRODUCERS] = {0};  // by producer: alu, load, immediate
+    long long control = 0, structural = 0, forwards[2] = {0, 0};
+    std::vector<Counts> counts;       // by pc - 1
+    int holding = 0;                  // cycles the instruction in ID has been held so far
+
+    void resize(size_t size)
+    {
+        counts.assign(size, Counts());
+    }
+
+    template <class Archive>
+    void checkpointState(Archive &archive)
+    {
+        archive(raw);
+        archive(control);
+        archive(structural);
+        archive(forwards);
+        archive(counts);
+        archive(holding);
+    }
+
+    // the instruction at pc is held in ID another cycle waiting on a producer of the given instruction type
+    void hold(int pc, int producerType)
+    {
+        int producer = producerType == 2 ? 1 : producerType == 3 ? 2 : 0;
+        ++raw[producer];
+        ++counts[pc - 1].raw;
+        counts[pc - 1].loadUse += producer == 1;
+        ++holding;
+    }
+
+    // the instruction at pc leaves ID
+    void release(int pc)
+    {
+        if (!holding)
+            return;
+        ++counts[pc - 1].held[std::min(holding, BUCKETS) - 1];
+        holding = 0;
+    }
+
+    void bubble(int pc, int cycles = 1)
+    {
+        control += cycles;
+        counts[pc - 1].control += cycles;
+    }
+
+    void freeze(int pc, int cycles)
+    {
+        structural += cycles;
+        counts[pc - 1].structural += cycles;
+    }
+
+    // path 0 for a result of EX, 1 for a result of MEM
+    void forward(int pc, int path)
+    {
+        ++forwards[path];
+        ++counts[pc - 1].forwards[path];
+    }
+
+    static std::string text(const Command &command)
+    {
+        std::string line;
+        for (auto &token : command)
+            if (!token.empty())
+                line.append(line.empty() ? "" : " ").append(token);
+        return line;
+    }
+
+    /*
+        write the report as JSON when path ends in .json, as CSV otherwise: one row per static instruction and
+        a last row of the totals, the split of the RAW stalls by producer only being in the JSON
+    */
+    bool write(const std::string &path, const char *model, int cycles, long long instructions,
+               const std::vector<Command> &commands) const
+    {
+        std::ofstream out(path);
+        if (!out.is_open())
+            return false;
+        bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+        if (json)
+            writeJSON(out, model, cycles, instructions, commands);
+        else
+            writeCSV(out, commands);
+        return (bool)out;
+    }
+
+    void writeJSON(std::ofstream &out, const char *model, int cycles, long long instructions,
+                   const std::vector<Command> &commands) const
+    {
+        out << "{\n  \"model\": \"" << model << "\",\n  \"cycles\": " << cycles << ",\n  \"instructions\": " << instructions
+            << ",\n  \"raw\": {\"total\": " << raw[0] + raw[1] + raw[2] << ", \"alu\": " << raw[0] << ", \"load\": " << raw[1]
+            << ", \"immediate\": " << raw[2] << "},\n  \"control\": " << control << ",\n  \"structural\": " << structural
+            << ",\n  \"forwards\": {\"ex\": " << forwards[0] << ", \"mem\": " << forwards[1] << "},\n  \"pcs\": [";
+        bool first = true;
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            const Counts &c = counts[i];
+            if (!(c.raw || c.control || c.structural || c.forwards[0] || c.forwards[1]))
+                continue;
+            out << (first ? "\n" : ",\n") << "    {\"pc\": " << i + 1 << ", \"instruction\": \"";
+            for (char ch : text(commands[i]))
+                out << (ch == '"' || ch == '\\' ? "\\" : "") << ch;
+            out << "\", \"raw\": " << c.raw << ", \"load_use\": " << c.loadUse << ", \"control\": " << c.control
+                << ", \"structural\": " << c.structural << ", \"forwards\": {\"ex\": " << c.forwards[0] << ", \"mem\": "
+                << c.forwards[1] << "}, \"held\": [";
+            for (int b = 0; b < BUCKETS; ++b)
+                out << c.held[b] << (b < BUCKETS - 1 ? ", " : "]}");
+            first = false;
+        }
+        out << (first ? "]\n}\n" : "\n  ]\n}\n");
+    }
+
+    void writeCSV(std::ofstream &out, const std::vector<Command> &commands) const
+    {
+        out << "pc,instruction,raw,load_use,control,structural,forward_ex,forward_mem,held_1,held_2,held_3,held_4,held_5+\n";
+        Counts total;
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            const Counts &c = counts[i];
+            out << i + 1 << ",\"";
+            for (char ch : text(commands[i]))
+                out << (ch == '"' ? "\"\"" : std::string(1, ch));
+            out << "\"," << c.raw << ',' << c.loadUse << ',' << c.control << ','
+                << c.structural << ',' << c.forwards[0] << ',' << c.forwards[1];
+            for (int b = 0; b < BUCKETS; ++b)
+                out << ',' << c.held[b];
+            out << '\n';
+            total.raw += c.raw;
+            total.loadUse += c.loadUse;
+            total.control += c.control;
+            total.structural += c.structural;
+            for (int p = 0; p < 2; ++p)
+                total.forwards[p] += c.forwards[p];
+            for (int b = 0; b < BUCKETS; ++b)
+                total.held[b] += c.held[b];
+        }
+        out << "total,," << total.raw << ',' << total.loadUse << ',' << total.control << ',' << total.structural << ','
+            << total.forwards[0] << ',' << total.forwards[1];
+        for (int b = 0; b < BUCKETS; ++b)
+            out << ',' << total.held[b];
+        out << '\n';
+    }
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef __THREAD_POOL_HPP__
+#define __THREAD_POOL_HPP__
+
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <functional>
+
+/*
+    work stealing pool for a fixed batch of independent jobs:
+    jobs are dealt round robin to one queue per worker, a worker takes from the back of its own queue and,
+    once that is empty, steals from the front of the others; run() returns when every queue is drained
+*/
+struct ThreadPool{
+    struct Queue{
+        std::mutex lock;
+        std::deque<std::function<void()>> jobs;
+    };
+
+    std::vector<Queue> queues;
+    size_t next = 0;
+
+    ThreadPool(size_t workers) : queues(workers ? workers : 1) {}
+
+    void submit(std::function<void()> job)
+    {
+        queues[next].jobs.push_back(std::move(job));
+        next = (next + 1) % queues.size();
+    }
+
+    bool take(size_t self, std::function<void()> &job)
+    {
+        {
+            std::lock_guard<std::mutex> guard(queues[self].lock);
+            if (!queues[self].jobs.empty())
+            {
+                job = std::move(queues[self].jobs.back());
+                queues[self].jobs.pop_back();
+                return true;
+            }
+        }
+        for (size_t i = 1; i < queues.size(); ++i)
+        {
+            Queue &victim = queues[(self + i) % queues.size()];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (!victim.jobs.empty())
+            {
+                job = std::move(victim.jobs.front());
+                victim.jobs.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // run every submitted job, the calling thread being one of the workers
+    void run()
+    {
+        auto work = [this](size_t self)
+        {
+            std::function<void()> job;
+            while (take(self, job))
+                job();
+        };
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < queues.size(); ++i)
+            threads.emplace_back(work, i);
+        work(0);
+        for (auto &thread : threads)
+            thread.join();
+    }
+};
+
+#endif
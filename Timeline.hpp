@@ -0,0 +1,189 @@
+#ifndef __TIMELINE_HPP__
+#define __TIMELINE_HPP__
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "Trace.hpp"
+
+/*
+    pipeline timeline of a pipelined run in the Kanata 0004 log format of the Konata pipeline viewer, streamed
+    through a TraceWriter as the run goes:
+        C= <cycle>              first cycle
+        C <cycles>              cycles elapsed since the previous command
+        I <id> <id> 0           instruction id (the dynamic instruction number) enters the pipeline
+        L <id> 0 <text>         its label, "<pc>: <instruction>"
+        S / E <id> 0 <stage>    start and end of a stage: IF, ID, St (held in ID by a data hazard), EX, MEM, WB
+        R <id> <retired> <0|1>  completed (0), or flushed off a wrong path (1)
+    fields are tab separated; an instruction caught in flight by the start of a restored run enters the log
+    with the first stage it is seen in
+    an instruction only moves forward: a stage re-run on an instruction that has moved on (EX re-executing its
+    occupant while ID is held) is ignored, ID and St alternating while it waits in ID; an instruction still in
+    flight when its slot is needed again or when the log closes is recorded as flushed
+*/
+enum TimelineStage : uint8_t{
+    TIMELINE_IF = 0,
+    TIMELINE_ID,
+    TIMELINE_STALL,
+    TIMELINE_EX,
+    TIMELINE_MEM,
+    TIMELINE_WB,
+    TIMELINE_NONE
+};
+
+struct Timeline{
+    static const int SLOTS = 64;  // more than the instructions ever in flight
+
+    struct Slot{
+        int id = 0;
+        TimelineStage stage = TIMELINE_NONE;
+    };
+
+    TraceWriter writer;
+    std::vector<std::string> labels;  // by pc - 1
+    Slot slots[SLOTS];
+    long long cycle = -1, retired = 0;
+
+    // labels of the instructions are "<pc>: <instruction>", given as the text of each command
+    bool open(const std::string &path, const std::vector<std::string> &texts)
+    {
+        if (!writer.open(path, nullptr))
+            return false;
+        labels.clear();
+        for (size_t i = 0; i < texts.size(); ++i)
+            labels.push_back(std::to_string(i + 1) + ": " + texts[i]);
+        putText("Kanata\t0004\n");
+        return true;
+    }
+
+    bool enabled() const
+    {
+        return writer.file != nullptr;
+    }
+
+    void putText(const char *text)
+    {
+        writer.put(text, std::strlen(text));
+    }
+
+    void putNumber(long long value)
+    {
+        char digits[24];
+        int size = 0;
+        bool negative = value < 0;
+        unsigned long long magnitude = negative ? -(unsigned long long)value : value;
+        do
+        {
+            digits[size++] = '0' + magnitude % 10;
+            magnitude /= 10;
+        } while (magnitude);
+        if (negative)
+            digits[size++] = '-';
+        writer.reserve(size);
+        while (size)
+            writer.buffer[writer.used++] = digits[--size];
+    }
+
+    // command with the instruction id and lane 0, e.g. "S\t<id>\t0\t"
+    void putCommand(const char *command, int id)
+    {
+        putText(command);
+        putNumber(id);
+        putText("\t0\t");
+    }
+
+    void putStage(const char *command, int id, TimelineStage stage)
+    {
+        static const char *const names[] = {"IF\n", "ID\n", "St\n", "EX\n", "MEM\n", "WB\n"};
+        putCommand(command, id);
+        putText(names[stage]);
+    }
+
+    // events that follow belong to cycle now
+    inline void advance(long long now)
+    {
+        if (!enabled() || now == cycle)
+            return;
+        putText(cycle < 0 ? "C=\t" : "C\t");
+        putNumber(cycle < 0 ? now : now - cycle);
+        putText("\n");
+        cycle = now;
+    }
+
+    // order of the stages an instruction moves through, ID and St sharing one
+    static int rank(TimelineStage stage)
+    {
+        static const int ranks[] = {0, 1, 1, 2, 3, 4, -1};
+        return ranks[stage];
+    }
+
+    // instruction id at pc enters the pipeline
+    void enter(int id, int pc)
+    {
+        Slot &slot = slots[id & (SLOTS - 1)];
+        if (slot.id)
+            leave(slot.id, true);
+        slot.id = id;
+        slot.stage = TIMELINE_NONE;
+        putText("I\t");
+        putNumber(id);
+        putText("\t");
+        putNumber(id);
+        putText("\t0\n");
+        putCommand("L\t", id);
+        writer.put(labels[pc - 1].data(), labels[pc - 1].size());
+        putText("\n");
+    }
+
+    // instruction id at pc occupies stage from this cycle on
+    inline void stage(int id, int pc, TimelineStage stage)
+    {
+        if ((!enabled()) || (pc < 1) || (pc > (int)labels.size()))
+            return;
+        Slot &slot = slots[id & (SLOTS - 1)];
+        if (slot.id != id)
+            enter(id, pc);
+        if (slot.stage == stage || rank(stage) < rank(slot.stage))
+            return;
+        if (slot.stage != TIMELINE_NONE)
+            putStage("E\t", id, slot.stage);
+        putStage("S\t", id, stage);
+        slot.stage = stage;
+    }
+
+    // instruction id leaves the pipeline, completed or flushed
+    inline void leave(int id, bool flushed)
+    {
+        if (!enabled())
+            return;
+        Slot &slot = slots[id & (SLOTS - 1)];
+        if (slot.id != id)
+            return;
+        if (slot.stage != TIMELINE_NONE)
+            putStage("E\t", id, slot.stage);
+        putText("R\t");
+        putNumber(id);
+        putText("\t");
+        putNumber(retired++);
+        putText(flushed ? "\t1\n" : "\t0\n");
+        slot = Slot();
+    }
+
+    // flush the instructions still in flight, oldest first
+    void close()
+    {
+        if (!enabled())
+            return;
+        std::vector<int> live;
+        for (auto &slot : slots)
+            if (slot.id)
+                live.push_back(slot.id);
+        std::sort(live.begin(), live.end());
+        for (int id : live)
+            leave(id, true);
+        writer.close();
+    }
+};
+
+#endif
@@ -0,0 +1,255 @@
+#ifndef __TRACE_HPP__
+#define __TRACE_HPP__
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <iostream>
+#include "Memory.hpp"
+
+/*
+    output modes of the simulators:
+    full:   all registers and the memory delta every cycle (default)
+    delta:  only the registers and memory words that changed, one line per cycle that changed anything
+    final:  the registers and every memory word written, once at the end of the run
+    binary: every cycle delta-encoded into a trace file, see the format below
+    none:   nothing at all, for batch runs that only collect statistics
+*/
+enum OutputMode{
+    OUTPUT_FULL = 0,
+    OUTPUT_DELTA,
+    OUTPUT_FINAL,
+    OUTPUT_BINARY,
+    OUTPUT_NONE
+};
+
+inline bool parseOutputMode(const std::string &arg, OutputMode &mode)
+{
+    if (arg == "--full")
+        mode = OUTPUT_FULL;
+    else if (arg == "--delta")
+        mode = OUTPUT_DELTA;
+    else if (arg == "--final")
+        mode = OUTPUT_FINAL;
+    else if (arg == "--binary")
+        mode = OUTPUT_BINARY;
+    else
+        return false;
+    return true;
+}
+
+/*
+    binary trace format:
+    header "MIPSTRC1", then one record per printed cycle:
+        tag byte (TRACE_CYCLE, or TRACE_LAST for the record the run stops on)
+        varint bitmask of the registers that changed since the previous record
+        zigzag varint of each changed register, lowest index first
+        varint number of memory delta entries followed by (zigzag address, zigzag value) pairs
+    and finally a TRACE_END tag
+    decode_trace turns it back into the text the --full mode prints
+*/
+static const char TRACE_MAGIC[8] = {'M', 'I', 'P', 'S', 'T', 'R', 'C', '1'};
+
+// branch traces: header "MIPSBRT1", then a varint of (pc << 1 | taken) per conditional branch in program order
+static const char BRANCH_MAGIC[8] = {'M', 'I', 'P', 'S', 'B', 'R', 'T', '1'};
+
+enum TraceTag : unsigned char{
+    TRACE_CYCLE = 0,
+    TRACE_LAST,
+    TRACE_END
+};
+
+inline uint32_t zigzag(int value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+inline int unzigzag(uint32_t value)
+{
+    return (int)(value >> 1) ^ -(int)(value & 1);
+}
+
+// buffered writer for binary traces (and text logs, without a magic), encoding straight into a large buffer that is
+// only written out when full
+struct TraceWriter{
+    static const size_t BUFFER_SIZE = 1 << 20;
+    std::FILE *file = nullptr;
+    std::vector<unsigned char> buffer;
+    size_t used = 0;
+
+    bool open(const std::string &path, const char *magic = TRACE_MAGIC)
+    {
+        file = std::fopen(path.c_str(), "wb");
+        buffer.resize(BUFFER_SIZE);
+        used = 0;
+        if (file && magic)
+            put(magic, sizeof(TRACE_MAGIC));
+        return file != nullptr;
+    }
+
+    void flush()
+    {
+        if (file && used)
+            std::fwrite(buffer.data(), 1, used, file);
+        used = 0;
+    }
+
+    void close()
+    {
+        flush();
+        if (file)
+            std::fclose(file);
+        file = nullptr;
+    }
+
+    // make room for at least size more bytes
+    inline void reserve(size_t size)
+    {
+        if (used + size > buffer.size())
+            flush();
+    }
+
+    inline void put(const void *src, size_t size)
+    {
+        reserve(size);
+        std::memcpy(buffer.data() + used, src, size);
+        used += size;
+    }
+
+    inline void putByte(unsigned char value)
+    {
+        reserve(1);
+        buffer[used++] = value;
+    }
+
+    inline void putVarint(uint32_t value)
+    {
+        reserve(5);
+        while (value >= 0x80)
+        {
+            buffer[used++] = (unsigned char)(value | 0x80);
+            value >>= 7;
+        }
+        buffer[used++] = (unsigned char)value;
+    }
+
+    ~TraceWriter()
+    {
+        close();
+    }
+};
+
+// reads back the records of a binary trace held in memory
+struct TraceReader{
+    const unsigned char *pos, *end;
+
+    TraceReader(const unsigned char *data, size_t size) : pos(data), end(data + size) {}
+
+    bool checkHeader(const char *magic = TRACE_MAGIC)
+    {
+        if (end - pos < (long)sizeof(TRACE_MAGIC) || std::memcmp(pos, magic, sizeof(TRACE_MAGIC)))
+            return false;
+        pos += sizeof(TRACE_MAGIC);
+        return true;
+    }
+
+    inline bool getByte(unsigned char &value)
+    {
+        if (pos == end)
+            return false;
+        value = *pos++;
+        return true;
+    }
+
+    inline bool getVarint(uint32_t &value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 35; shift += 7)
+        {
+            if (pos == end)
+                return false;
+            unsigned char byte = *pos++;
+            value |= (uint32_t)(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+};
+
+// records the outcome of every conditional branch, for replaying through predictors offline
+struct BranchTrace{
+    TraceWriter writer;
+
+    bool open(const std::string &path)
+    {
+        return writer.open(path, BRANCH_MAGIC);
+    }
+
+    // pc is the 0-based index of the branch, as the predictors see it
+    inline void record(uint32_t pc, bool taken)
+    {
+        if (writer.file)
+            writer.putVarint(pc << 1 | taken);
+    }
+};
+
+struct Tracer{
+    OutputMode mode = OUTPUT_FULL;
+    int previous[32] = {0};
+    TraceWriter writer;
+
+    // print the registers that changed since the last call along with the memory delta
+    void printDelta(int clockCycle, const int *registers, const PagedMemory &memory)
+    {
+        int changed = 0;
+        for (int i = 0; i < 32; ++i)
+            changed += registers[i] != previous[i];
+        if (!changed && !memory.deltaSize)
+            return;
+        std::cout << clockCycle << ' ' << changed << ' ';
+        for (int i = 0; i < 32; ++i)
+            if (registers[i] != previous[i])
+            {
+                std::cout << i << ' ' << registers[i] << ' ';
+                previous[i] = registers[i];
+            }
+        std::cout << memory.deltaSize << ' ';
+        memory.forEachDelta([](int address, int value)
+                            { std::cout << address << ' ' << value << ' '; });
+        std::cout << '\n';
+    }
+
+    // record the registers that changed since the previous record and the memory delta
+    void writeBinary(const int *registers, const PagedMemory &memory, bool last)
+    {
+        uint32_t mask = 0;
+        for (int i = 0; i < 32; ++i)
+            if (registers[i] != previous[i])
+                mask |= 1u << i;
+        writer.putByte(last ? TRACE_LAST : TRACE_CYCLE);
+        writer.putVarint(mask);
+        for (int i = 0; i < 32; ++i)
+            if (mask >> i & 1)
+            {
+                writer.putVarint(zigzag(registers[i]));
+                previous[i] = registers[i];
+            }
+        writer.putVarint(memory.deltaSize);
+        memory.forEachDelta([this](int address, int value)
+                            {
+                                writer.putVarint(zigzag(address));
+                                writer.putVarint(zigzag(value));
+                            });
+    }
+
+    void endBinary()
+    {
+        writer.putByte(TRACE_END);
+        writer.flush();
+    }
+};
+
+#endif
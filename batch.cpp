@@ -0,0 +1,91 @@
+#include "Manifest.hpp"
+#include "ThreadPool.hpp"
+#include <cstdio>
+
+/*
+    batch driver: runs every line of a manifest (see Manifest.hpp) as an independent simulation on a work stealing
+    thread pool and prints one table of the results
+*/
+
+template <class Architecture>
+void runJob(ManifestJob &job, const SimulatorOptions &options)
+{
+    AnyBranchPredictor *predictor = nullptr;
+    if (!options.predictor.empty() && !(predictor = makePredictor(options.predictor)))
+    {
+        job.status = "bad predictor";
+        return;
+    }
+    std::unique_ptr<Architecture> mips = loadJob<Architecture>(job, options, predictor);
+    if (mips)
+        executeJob(job, options, *mips);
+}
+
+void printTable(const std::vector<ManifestJob> &jobs, bool csv)
+{
+    std::vector<std::vector<std::string>> rows = {{"program", "model", "flags", "status", "cycles", "instructions", "CPI", "stalls"}};
+    for (auto &job : jobs)
+    {
+        char cpi[32] = "-";
+        if (job.instructions)
+            std::snprintf(cpi, sizeof(cpi), "%.3f", (double)job.cycles / job.instructions);
+        rows.push_back({job.args.size() > 1 ? job.args[1] : "", job.model, job.flags, job.status, std::to_string(job.cycles),
+                        std::to_string(job.instructions), cpi, std::to_string(job.stalls)});
+    }
+    printRows(rows, csv);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *usage = "./run_batch <manifest> [--threads <count>] [--csv]\n"
+                        "count between 1 and 1024\n";
+    if (argc < 2)
+    {
+        std::cerr << usage;
+        return 0;
+    }
+    size_t threads = std::thread::hardware_concurrency();
+    bool csv = false;
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool valid = true;
+        if (arg == "--threads" && i + 1 < argc)
+        {
+            try
+            {
+                int count = std::stoi(argv[++i]);
+                valid = count >= 1 && count <= 1024;
+                threads = count;
+            }
+            catch (std::exception &e)
+            {
+                valid = false;
+            }
+        }
+        else if (arg == "--csv")
+            csv = true;
+        else
+            valid = false;
+        if (!valid)
+        {
+            std::cerr << usage;
+            return 0;
+        }
+    }
+    std::ios::sync_with_stdio(false);
+    std::vector<ManifestJob> jobs;
+    if (!readManifest(argv[1], "batch", jobs))
+    {
+        std::cerr << "Manifest could not be opened. Terminating...\n";
+        return 0;
+    }
+    ThreadPool pool(threads);
+    for (auto &job : jobs)
+        pool.submit([&job]()
+                    { dispatchJob(job, [&job](auto *architecture, const SimulatorOptions &options)
+                                  { runJob<typename std::remove_pointer<decltype(architecture)>::type>(job, options); }); });
+    pool.run();
+    printTable(jobs, csv);
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include "Manifest.hpp"
+#include <chrono>
+#include <cstdio>
+
+/*
+    benchmark harness: times the pipelined simulation of every line of a suite, a manifest as run_batch's (see
+    Manifest.hpp), to catch performance regressions of the simulator itself
+    the runs go one after the other on this thread, each job being run once to warm up and then timed --runs
+    times; only executeCommandsPipelined is timed (not the parsing), the best time giving the throughput and the
+    median showing the noise, and every timed run has to reproduce the cycle count of the first
+    the warm-up run is checked against a functional run of the program: a pipeline that stops early or computes
+    another final state (registers and memory) is marked invalid and not timed, as its rates would mean nothing
+*/
+
+struct BenchJob : ManifestJob{
+    std::vector<double> seconds;    // timed runs
+};
+
+// the final state of a completed pipelined run is the one of a functional run of its program
+template <class Architecture>
+bool matchesFunctional(const Architecture &mips, const SimulatorOptions &options)
+{
+    SourceFile file;
+    if (!file.open(options.fileName))
+        return false;
+    std::unique_ptr<Architecture> golden(new Architecture(file));
+    int pc = 0;
+    // a pipeline completes at most one instruction a cycle
+    FunctionalResult result = executeFunctional(*golden, pc, mips.cycles);
+    return result.exitCode == 0 && pc >= (int)golden->program.size() && result.instructions == mips.instructions &&
+           std::equal(mips.registers, mips.registers + 32, golden->registers) && mips.data.sameWords(golden->data);
+}
+
+// one run of the job, false if it could not complete
+template <class Architecture>
+bool runOnce(BenchJob &job, const SimulatorOptions &options, typename Architecture::Predictor *predictor, double &seconds)
+{
+    std::unique_ptr<Architecture> mips = loadJob<Architecture>(job, options, predictor);
+    if (!mips)
+        return false;
+    bool warmUp = job.status == "not run";
+    int cycles = job.cycles;
+    long long instructions = job.instructions;
+    auto start = std::chrono::steady_clock::now();
+    if (!executeJob(job, options, *mips))
+        return false;
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!warmUp && (job.cycles != cycles || job.instructions != instructions))
+    {
+        job.status = "unstable";
+        return false;
+    }
+    // a restored run only covers the end of the program
+    if (warmUp && job.status == "ok" && options.restorePath.empty() && !matchesFunctional(*mips, options))
+    {
+        job.status = "invalid";
+        return false;
+    }
+    return true;
+}
+
+template <class Predictor>
+Predictor *copyOf(const Predictor *prototype)
+{
+    return new Predictor(*prototype);
+}
+
+// without a predictor the pipeline keeps the type erased default, which is never copied
+inline AnyBranchPredictor *copyOf(const AnyBranchPredictor *)
+{
+    return nullptr;
+}
+
+// warm up, then time the job, every run starting from a copy of the fresh predictor prototype (none when null)
+template <class Pipeline>
+void timeJob(BenchJob &job, const SimulatorOptions &options, int runs, typename Pipeline::Predictor *prototype)
+{
+    double seconds;
+    for (int run = 0; run <= runs; ++run)
+    {
+        if (!runOnce<Pipeline>(job, options, prototype ? copyOf(prototype) : nullptr, seconds))
+            break;
+        if (run)
+            job.seconds.push_back(seconds);
+    }
+    delete prototype;
+}
+
+// the predictor named in the flags is bound statically, as in the simulators
+template <class Architecture>
+void runJob(BenchJob &job, const SimulatorOptions &options, int runs)
+{
+    auto time = [&](auto *prototype)
+    {
+        typedef typename std::remove_pointer<decltype(prototype)>::type Predictor;
+        timeJob<typename Architecture::template WithPredictor<Predictor>>(job, options, runs, prototype);
+    };
+    if (options.predictor.empty())
+        timeJob<Architecture>(job, options, runs, nullptr);
+    else if (!withPredictor(options.predictor, time))
+        job.status = "bad predictor";
+}
+
+void printTable(const std::vector<BenchJob> &jobs, bool csv)
+{
+    std::vector<std::vector<std::string>> rows = {{"program", "model", "flags", "status", "cycles", "instructions", "CPI",
+                                                   "best ms", "median ms", "Mcycles/s", "Minstr/s"}};
+    for (auto &job : jobs)
+    {
+        char cpi[32] = "-", best[32] = "-", median[32] = "-", cycleRate[32] = "-", instructionRate[32] = "-";
+        if (job.instructions)
+            std::snprintf(cpi, sizeof(cpi), "%.3f", (double)job.cycles / job.instructions);
+        if (!job.seconds.empty() && (job.status == "ok" || job.status == "limit"))
+        {
+            std::vector<double> seconds = job.seconds;
+            std::sort(seconds.begin(), seconds.end());
+            double fastest = std::max(seconds[0], 1e-9);
+            std::snprintf(best, sizeof(best), "%.3f", 1e3 * seconds[0]);
+            std::snprintf(median, sizeof(median), "%.3f", 1e3 * seconds[seconds.size() / 2]);
+            std::snprintf(cycleRate, sizeof(cycleRate), "%.2f", job.cycles / fastest / 1e6);
+            std::snprintf(instructionRate, sizeof(instructionRate), "%.2f", job.instructions / fastest / 1e6);
+        }
+        rows.push_back({job.args.size() > 1 ? job.args[1] : "", job.model, job.flags, job.status, std::to_string(job.cycles),
+                        std::to_string(job.instructions), cpi, best, median, cycleRate, instructionRate});
+    }
+    printRows(rows, csv);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "./run_bench <suite> [--runs <count>] [--csv]\n";
+        return 0;
+    }
+    int runs = 10;
+    bool csv = false;
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc)
+            runs = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--csv")
+            csv = true;
+    }
+    std::ios::sync_with_stdio(false);
+    std::vector<BenchJob> jobs;
+    if (!readManifest(argv[1], "bench", jobs))
+    {
+        std::cerr << "Suite could not be opened. Terminating...\n";
+        return 0;
+    }
+    for (auto &job : jobs)
+        dispatchJob(job, [&](auto *architecture, const SimulatorOptions &options)
+                    { runJob<typename std::remove_pointer<decltype(architecture)>::type>(job, options, runs); });
+    printTable(jobs, csv);
+    return 0;
+}
@@ -0,0 +1,29 @@
+# tight data dependent branches: a sequence x = (5x + 3) mod 64 drives two tests per step, counting
+# the steps with x below 32 and those with x a multiple of 4
+addi $s0, $zero, 64
+addi $s1, $zero, 32
+addi $s2, $zero, 5000
+addi $t0, $zero, 1
+addi $t1, $zero, 0
+addi $t2, $zero, 0
+addi $t3, $zero, 0
+step: add $t4, $t0, $t0
+add $t4, $t4, $t4
+add $t0, $t4, $t0
+addi $t0, $t0, 3
+wrap: slt $t4, $t0, $s0
+bne $t4, $zero, wrapped
+sub $t0, $t0, $s0
+j wrap
+wrapped: slt $t4, $t0, $s1
+beq $t4, $zero, high
+addi $t1, $t1, 1
+high: add $t4, $t0, $zero
+quarter: slt $t5, $t4, $zero
+bne $t5, $zero, odd
+beq $t4, $zero, even
+addi $t4, $t4, -4
+j quarter
+even: addi $t2, $t2, 1
+odd: addi $t3, $t3, 1
+bne $t3, $s2, step
@@ -0,0 +1,35 @@
+# linked list walk: 1000 nodes of two words (value, address of the next node) at 4000,
+# node i linked to node (i + 373) mod 1000 so that consecutive nodes lie far apart,
+# then the list is walked 4 times summing the values into the word at 12000
+addi $s0, $zero, 1000
+addi $s1, $zero, 4000
+addi $s2, $zero, 373
+addi $t0, $zero, 0
+link: add $t1, $t0, $s2
+slt $t2, $t1, $s0
+bne $t2, $zero, linked
+sub $t1, $t1, $s0
+linked: add $t3, $t0, $t0
+add $t3, $t3, $t3
+add $t3, $t3, $t3
+add $t3, $s1, $t3
+add $t4, $t1, $t1
+add $t4, $t4, $t4
+add $t4, $t4, $t4
+add $t4, $s1, $t4
+sw $t0, 0($t3)
+sw $t4, 4($t3)
+addi $t0, $t0, 1
+bne $t0, $s0, link
+addi $t5, $zero, 0
+addi $t6, $zero, 4
+pass: add $t3, $s1, $zero
+addi $t0, $zero, 0
+walk: lw $t1, 0($t3)
+add $t5, $t5, $t1
+lw $t3, 4($t3)
+addi $t0, $t0, 1
+bne $t0, $s0, walk
+addi $t6, $t6, -1
+bne $t6, $zero, pass
+sw $t5, 8000($s1)
@@ -0,0 +1,53 @@
+# C = A * B for 16 x 16 word matrices, A at 4096, B at 5120, C at 6144
+# A[i][j] = i + j and B[i][j] = i - j + 1 are filled first
+addi $s0, $zero, 16
+addi $s1, $zero, 4096
+addi $s2, $zero, 5120
+addi $s3, $zero, 6144
+addi $t0, $zero, 0
+fill_row: addi $t1, $zero, 0
+fill_col: mul $t2, $t0, $s0
+add $t2, $t2, $t1
+add $t2, $t2, $t2
+add $t2, $t2, $t2
+add $t3, $t0, $t1
+add $t4, $s1, $t2
+sw $t3, 0($t4)
+sub $t3, $t0, $t1
+addi $t3, $t3, 1
+add $t4, $s2, $t2
+sw $t3, 0($t4)
+addi $t1, $t1, 1
+bne $t1, $s0, fill_col
+addi $t0, $t0, 1
+bne $t0, $s0, fill_row
+addi $t0, $zero, 0
+row: addi $t1, $zero, 0
+col: addi $t5, $zero, 0
+addi $t6, $zero, 0
+dot: mul $t2, $t0, $s0
+add $t2, $t2, $t6
+add $t2, $t2, $t2
+add $t2, $t2, $t2
+add $t2, $s1, $t2
+lw $t3, 0($t2)
+mul $t2, $t6, $s0
+add $t2, $t2, $t1
+add $t2, $t2, $t2
+add $t2, $t2, $t2
+add $t2, $s2, $t2
+lw $t4, 0($t2)
+mul $t3, $t3, $t4
+add $t5, $t5, $t3
+addi $t6, $t6, 1
+bne $t6, $s0, dot
+mul $t2, $t0, $s0
+add $t2, $t2, $t1
+add $t2, $t2, $t2
+add $t2, $t2, $t2
+add $t2, $s3, $t2
+sw $t5, 0($t2)
+addi $t1, $t1, 1
+bne $t1, $s0, col
+addi $t0, $t0, 1
+bne $t0, $s0, row
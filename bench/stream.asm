@@ -0,0 +1,32 @@
+# memory streaming: a[i] = i and b[i] = 2i filled at 8000 and 16000, then c[i] = a[i] + b[i] at 24000,
+# 2000 words each, the whole pass repeated 3 times
+addi $s0, $zero, 2000
+addi $s1, $zero, 8000
+addi $s2, $zero, 16000
+addi $s3, $zero, 24000
+addi $t0, $zero, 0
+addi $t1, $s1, 0
+addi $t2, $s2, 0
+fill: sw $t0, 0($t1)
+add $t3, $t0, $t0
+sw $t3, 0($t2)
+addi $t0, $t0, 1
+addi $t1, $t1, 4
+addi $t2, $t2, 4
+bne $t0, $s0, fill
+addi $t6, $zero, 3
+pass: addi $t0, $zero, 0
+addi $t1, $s1, 0
+addi $t2, $s2, 0
+addi $t3, $s3, 0
+sum: lw $t4, 0($t1)
+lw $t5, 0($t2)
+add $t4, $t4, $t5
+sw $t4, 0($t3)
+addi $t0, $t0, 1
+addi $t1, $t1, 4
+addi $t2, $t2, 4
+addi $t3, $t3, 4
+bne $t0, $s0, sum
+addi $t6, $t6, -1
+bne $t6, $zero, pass
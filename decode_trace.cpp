@@ -0,0 +1,112 @@
+#include "Trace.hpp"
+#include <charconv>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// text output buffer, written to stdout whenever it fills up
+struct TextBuffer{
+	std::vector<char> buffer = std::vector<char>(1 << 20);
+	size_t used = 0;
+
+	void flush()
+	{
+		std::fwrite(buffer.data(), 1, used, stdout);
+		used = 0;
+	}
+
+	inline void putInt(long long value)
+	{
+		if (used + 24 > buffer.size())
+			flush();
+		used = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value).ptr - buffer.data();
+		buffer[used++] = ' ';
+	}
+
+	inline void putChar(char c)
+	{
+		if (used + 1 > buffer.size())
+			flush();
+		buffer[used++] = c;
+	}
+};
+
+// reproduce the --full text output of the simulators from a binary trace
+int main(int argc, char *argv[])
+{
+	if (argc != 2)
+	{
+		std::cerr << "Required argument: trace_file\n./decode_trace <trace file>\n";
+		return 0;
+	}
+	int fd = open(argv[1], O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) < 0)
+	{
+		std::cerr << "Trace file could not be opened. Terminating...\n";
+		return 1;
+	}
+	const unsigned char *data = nullptr;
+	if (st.st_size > 0)
+	{
+		void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped == MAP_FAILED)
+		{
+			std::cerr << "Trace file could not be mapped. Terminating...\n";
+			return 1;
+		}
+		data = (const unsigned char *)mapped;
+	}
+	TraceReader reader(data, st.st_size);
+	if (!reader.checkHeader())
+	{
+		std::cerr << "Not a binary trace\n";
+		return 1;
+	}
+
+	TextBuffer out;
+	int registers[32] = {0};
+	while (1)
+	{
+		unsigned char tag;
+		uint32_t mask, value, entries, address;
+		if (!reader.getByte(tag))
+			break;
+		if (tag == TRACE_END)
+		{
+			// the newline handleExit prints
+			out.putChar('\n');
+			out.flush();
+			return 0;
+		}
+		if (!reader.getVarint(mask))
+			break;
+		for (int i = 0; i < 32; ++i)
+			if (mask >> i & 1)
+			{
+				if (!reader.getVarint(value))
+					goto truncated;
+				registers[i] = unzigzag(value);
+			}
+		for (int i = 0; i < 32; ++i)
+			out.putInt(registers[i]);
+		out.putChar('\n');
+		if (!reader.getVarint(entries))
+			break;
+		out.putInt(entries);
+		for (uint32_t i = 0; i < entries; ++i)
+		{
+			if (!reader.getVarint(address) || !reader.getVarint(value))
+				goto truncated;
+			out.putInt(unzigzag(address));
+			out.putInt(unzigzag(value));
+		}
+		if (tag != TRACE_LAST)
+			out.putChar('\n');
+	}
+truncated:
+	out.flush();
+	std::cerr << "Truncated trace\n";
+	return 1;
+}
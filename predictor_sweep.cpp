@@ -0,0 +1,189 @@
+#include "Trace.hpp"
+#include "ThreadPool.hpp"
+#include <sstream>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+    design space sweep of 2-bit counter predictors over a recorded branch trace (see --branch-trace)
+    every configuration indexes one table of counters with the low pc bits of the branch followed by the
+    global history bits, the same scheme as the predictors of BranchPredictor.hpp:
+        SaturatingBranchPredictor(v)          pc bits 14, history bits 0, initial v
+        BHRBranchPredictor(v)                 pc bits 0,  history bits 2, initial v
+        SaturatingBHRBranchPredictor(v, 1<<16) pc bits 14, history bits 2, initial v
+    the initial value seeds both the counters and the history register, as in their constructors
+*/
+
+struct SweepConfig{
+    int pcBits, historyBits, initial;
+    long long mispredicts = 0;
+};
+
+// configurations replayed together, so that the trace is streamed once per group
+static const int GROUP = 16;
+
+// branch outcomes held once in memory and shared by every worker
+struct BranchOutcomes{
+    std::vector<uint32_t> pcs;
+    std::vector<uint8_t> taken;
+};
+
+/*
+    replay the trace through configs[first, last): the configurations of a group are laid out as arrays that
+    the inner loop walks side by side, and each counter update is branch free
+*/
+void replay(const BranchOutcomes &trace, std::vector<SweepConfig> &configs, size_t first, size_t last)
+{
+    int count = last - first;
+    uint32_t pcMask[GROUP], historyMask[GROUP], history[GROUP], offset[GROUP];
+    int historyBits[GROUP];
+    long long wrong[GROUP] = {0};
+    size_t total = 0;
+    for (int k = 0; k < count; ++k)
+    {
+        const SweepConfig &config = configs[first + k];
+        pcMask[k] = (1u << config.pcBits) - 1;
+        historyBits[k] = config.historyBits;
+        historyMask[k] = (1u << config.historyBits) - 1;
+        history[k] = config.initial;
+        offset[k] = total;
+        total += (size_t)1 << (config.pcBits + config.historyBits);
+    }
+    std::vector<uint8_t> counters(total);
+    for (int k = 0; k < count; ++k)
+        std::fill(counters.begin() + offset[k], counters.begin() + offset[k] + ((size_t)1 << (configs[first + k].pcBits + historyBits[k])), configs[first + k].initial);
+    const uint32_t *pcs = trace.pcs.data();
+    const uint8_t *taken = trace.taken.data();
+    for (size_t i = 0, n = trace.pcs.size(); i < n; ++i)
+    {
+        uint32_t pc = pcs[i], t = taken[i];
+        for (int k = 0; k < count; ++k)
+        {
+            uint32_t index = offset[k] + ((pc & pcMask[k]) << historyBits[k] | (history[k] & historyMask[k]));
+            uint32_t counter = counters[index];
+            wrong[k] += (counter >> 1) ^ t;
+            counters[index] = counter + (t & (counter != 3)) - ((t ^ 1) & (counter != 0));
+            history[k] = history[k] << 1 | t;
+        }
+    }
+    for (int k = 0; k < count; ++k)
+        configs[first + k].mispredicts = wrong[k];
+}
+
+bool loadTrace(const char *path, BranchOutcomes &trace)
+{
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0 || st.st_size == 0)
+    {
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+    void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+        return false;
+    TraceReader reader((const unsigned char *)mapped, st.st_size);
+    bool valid = reader.checkHeader(BRANCH_MAGIC);
+    uint32_t value;
+    while (valid && reader.pos != reader.end)
+    {
+        if (!(valid = reader.getVarint(value)))
+            break;
+        trace.pcs.push_back(value >> 1);
+        trace.taken.push_back(value & 1);
+    }
+    munmap(mapped, st.st_size);
+    return valid;
+}
+
+bool parseList(const std::string &arg, std::vector<int> &values, int low, int high)
+{
+    values.clear();
+    std::istringstream items(arg);
+    std::string item;
+    while (getline(items, item, ','))
+    {
+        try
+        {
+            values.push_back(std::stoi(item));
+        }
+        catch (std::exception &e)
+        {
+            return false;
+        }
+        if (values.back() < low || values.back() > high)
+            return false;
+    }
+    return !values.empty();
+}
+
+int main(int argc, char *argv[])
+{
+    const char *usage = "./run_sweep <branch trace file> [--pc-bits <list>] [--history-bits <list>] [--initial <list>] [--threads <count>]\n"
+                        "lists are comma separated, pc bits and history bits together at most 24, count between 1 and 1024\n";
+    if (argc < 2)
+    {
+        std::cerr << usage;
+        return 0;
+    }
+    std::vector<int> pcBits = {0, 2, 4, 6, 8, 10, 12, 14}, historyBits = {0, 1, 2, 4, 8}, initial = {0, 1, 2, 3};
+    size_t threads = std::thread::hardware_concurrency();
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool valid = i + 1 < argc;
+        if (valid && arg == "--pc-bits")
+            valid = parseList(argv[++i], pcBits, 0, 24);
+        else if (valid && arg == "--history-bits")
+            valid = parseList(argv[++i], historyBits, 0, 24);
+        else if (valid && arg == "--initial")
+            valid = parseList(argv[++i], initial, 0, 3);
+        else if (valid && arg == "--threads")
+        {
+            std::vector<int> count;
+            valid = parseList(argv[++i], count, 1, 1024) && count.size() == 1;
+            threads = valid ? count[0] : threads;
+        }
+        else
+            valid = false;
+        if (!valid)
+        {
+            std::cerr << usage;
+            return 0;
+        }
+    }
+    BranchOutcomes trace;
+    if (!loadTrace(argv[1], trace))
+    {
+        std::cerr << "Branch trace could not be read. Terminating...\n";
+        return 0;
+    }
+    std::vector<SweepConfig> configs;
+    for (int p : pcBits)
+        for (int h : historyBits)
+            if (p + h <= 24)
+                for (int v : initial)
+                    configs.push_back({p, h, v});
+
+    ThreadPool pool(threads);
+    for (size_t first = 0; first < configs.size(); first += GROUP)
+    {
+        size_t last = std::min(first + GROUP, configs.size());
+        pool.submit([&, first, last]()
+                    { replay(trace, configs, first, last); });
+    }
+    pool.run();
+
+    std::printf("branches %zu\n%-8s %-12s %-7s %-8s %-11s %s\n", trace.pcs.size(), "pc bits", "history bits", "initial", "entries",
+                "mispredicts", "accuracy");
+    for (auto &config : configs)
+        std::printf("%-8d %-12d %-7d %-8lu %-11lld %.2f%%\n", config.pcBits, config.historyBits, config.initial,
+                    1ul << (config.pcBits + config.historyBits), config.mispredicts,
+                    trace.pcs.empty() ? 100.0 : 100.0 * (trace.pcs.size() - config.mispredicts) / trace.pcs.size());
+    return 0;
+}